@@ -68,6 +68,9 @@ public:
   /// Retrieve the module options
   ModuleOptions getModuleOptions() const;
 
+  /// Retrieve the buffer holding the binary API notes that this reader reads.
+  const llvm::MemoryBuffer &getBuffer() const;
+
   /// Captures the completed versioned information for a particular part of
   /// API notes, including both unversioned API notes and each versioned API
   /// note for that particular entity.
@@ -84,6 +84,7 @@ class TypeSourceInfo;
     friend class ASTNodeImporter;
   public:
     using NonEquivalentDeclSet = llvm::DenseSet<std::pair<Decl *, Decl *>>;
+    using EquivalentDeclSet = llvm::DenseSet<std::pair<Decl *, Decl *>>;
     using ImportedCXXBaseSpecifierMap =
         llvm::DenseMap<const CXXBaseSpecifier *, CXXBaseSpecifier *>;
 
@@ -275,6 +276,11 @@ class TypeSourceInfo;
     /// (which we have already complained about).
     NonEquivalentDeclSet NonEquivalentDecls;
 
+    /// Declaration (from, to) pairs that an earlier structural equivalence
+    /// check proved to be equivalent, so that repeated imports do not check
+    /// the same large records again.
+    EquivalentDeclSet EquivalentDecls;
+
     using FoundDeclsTy = SmallVector<NamedDecl *, 2>;
     FoundDeclsTy findDeclsInToCtx(DeclContext *DC, DeclarationName Name);
 
@@ -523,6 +529,9 @@ class TypeSourceInfo;
     /// Return the set of declarations that we know are not equivalent.
     NonEquivalentDeclSet &getNonEquivalentDecls() { return NonEquivalentDecls; }
 
+    /// Return the set of declarations that we know are equivalent.
+    EquivalentDeclSet &getEquivalentDecls() { return EquivalentDecls; }
+
     /// Called for ObjCInterfaceDecl, ObjCProtocolDecl, and TagDecl.
     /// Mark the Decl as complete, filling it in as much as possible.
     ///
@@ -55,6 +55,11 @@ struct StructuralEquivalenceContext {
   /// (which we have already complained about).
   llvm::DenseSet<std::pair<Decl *, Decl *>> &NonEquivalentDecls;
 
+  /// Declaration (from, to) pairs that an earlier check proved to be
+  /// equivalent, or null. When set, pairs proven equivalent by this context
+  /// are added, and known pairs are not checked again.
+  llvm::DenseSet<std::pair<Decl *, Decl *>> *EquivalentDecls = nullptr;
+
   StructuralEquivalenceKind EqKind;
 
   /// Whether we're being strict about the spelling of types when
@@ -122,6 +127,10 @@ private:
   /// false if equivalence was detected.
   bool Finish();
 
+  /// Add the tentative equivalences, all of which a successful \c Finish
+  /// has proven, to \c EquivalentDecls where that is safe.
+  void recordEquivalences();
+
   /// Check for common properties at Finish.
   /// \returns true if D1 and D2 may be equivalent,
   /// false if they are for sure not.
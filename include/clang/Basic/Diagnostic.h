@@ -22,6 +22,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Compiler.h"
@@ -32,6 +33,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -322,6 +324,8 @@ private:
     /// Clear out this map.
     void clear() {
       Files.clear();
+      LastLookupFID = FileID();
+      LastLookupFile = nullptr;
       FirstDiagState = CurDiagState = nullptr;
       CurDiagStateLoc = SourceLocation();
     }
@@ -378,6 +382,13 @@ private:
     /// The diagnostic states for each file.
     mutable std::map<FileID, File> Files;
 
+    /// The file most recently returned by getFile(). Diagnostic queries come
+    /// in long runs against the same file, so this saves a map lookup per
+    /// query. Entries in \c Files are never erased individually, so the
+    /// pointer stays valid until the map is cleared.
+    mutable FileID LastLookupFID;
+    mutable File *LastLookupFile = nullptr;
+
     /// The initial diagnostic state.
     DiagState *FirstDiagState;
 
@@ -393,6 +404,16 @@ private:
 
   DiagStateMap DiagStatesByLoc;
 
+  /// The states created by applying a diagnostic pragma to an existing state,
+  /// keyed by that state and by the pragma's flavor, severity and group.
+  ///
+  /// Headers that repeatedly push, ignore and pop the same warnings then share
+  /// one state per distinct pragma rather than copying the whole mapping table
+  /// at every pragma.
+  std::map<std::tuple<DiagState *, unsigned, unsigned, std::string>,
+           DiagState *>
+      DerivedDiagStates;
+
   /// Keeps the DiagState that was active during each diagnostic 'push'
   /// so we can get back at it when we 'pop'.
   std::vector<DiagState *> DiagStateOnPushStack;
@@ -403,6 +424,13 @@ private:
 
   void PushDiagStatePoint(DiagState *State, SourceLocation L);
 
+  /// Run \p Apply, which maps every diagnostic of \p Group (or all
+  /// diagnostics, if \p Group is empty) to \p Map at \p Loc, reusing the
+  /// state produced by an identical earlier pragma where possible.
+  void applyPragmaMapping(diag::Flavor Flavor, StringRef Group,
+                          diag::Severity Map, SourceLocation Loc,
+                          llvm::function_ref<void()> Apply);
+
   /// Finds the DiagStatePoint that contains the diagnostic state of
   /// the given source location.
   DiagState *GetDiagStateForLoc(SourceLocation Loc) const {
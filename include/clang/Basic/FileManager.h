@@ -222,10 +222,15 @@ class FileManager : public RefCountedBase<FileManager> {
   // Statistics.
   unsigned NumDirLookups, NumFileLookups;
   unsigned NumDirCacheMisses, NumFileCacheMisses;
+  unsigned NumStatsPrefetched = 0;
 
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
 
+  /// The results of stats made by \c prefetchFileStats that have not been
+  /// used by a file lookup yet.
+  llvm::StringMap<llvm::vfs::Status> PrefetchedStats;
+
   std::error_code getStatValue(StringRef Path, llvm::vfs::Status &Status,
                                bool isFile,
                                std::unique_ptr<llvm::vfs::File> *F);
@@ -237,6 +242,11 @@ class FileManager : public RefCountedBase<FileManager> {
   /// Fills the RealPathName in file entry.
   void fillRealPathName(FileEntry *UFE, llvm::StringRef FileName);
 
+  /// Reads the contents of \p Entry from the file system.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  readBufferForFile(const FileEntry *Entry, bool isVolatile,
+                    bool ShouldCloseOpenFile);
+
 public:
   /// Construct a file manager, optionally with a custom VFS.
   ///
@@ -358,12 +368,26 @@ public:
 
   /// Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.
+  ///
+  /// If \c FileSystemOptions::ShareFileBuffers is set and the file is not
+  /// volatile, the returned buffer shares its contents with the buffers other
+  /// file managers in the process returned for the same file.
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(const FileEntry *Entry, bool isVolatile = false,
                    bool ShouldCloseOpenFile = true);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
   getBufferForFile(StringRef Filename, bool isVolatile = false);
 
+  /// Returns the number of files whose contents the file managers in the
+  /// process currently share.
+  static unsigned getNumSharedFileBuffers();
+
+  /// Stat the files at \p Paths in parallel, so that the next lookup of each
+  /// of them that does not open it can use the result instead of a stat.
+  ///
+  /// Does nothing unless \c FileSystemOptions::PrefetchFileStats is set.
+  void prefetchFileStats(ArrayRef<std::string> Paths);
+
   /// Get the 'stat' information for the given \p Path.
   ///
   /// If the path is relative, it will be resolved against the WorkingDir of the
@@ -24,6 +24,18 @@ public:
   /// If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// If set, file contents are shared with the other file managers in the
+  /// process that read the same, unmodified file, instead of being read again.
+  /// Files are identified by their unique ID, so this must only be set if
+  /// every file system in the process returns the same contents for them.
+  bool ShareFileBuffers = false;
+
+  /// If set, the input files of AST files are stat'ed on several threads
+  /// before they are validated. This must only be set if the virtual file
+  /// system allows concurrent calls to \c status(), which caching file
+  /// systems such as the one of the dependency scanner do not.
+  bool PrefetchFileStats = false;
 };
 
 } // end namespace clang
@@ -61,6 +61,14 @@ public:
   /// The file to write GraphViz-formatted header dependencies to.
   std::string DOTOutputFile;
 
+  /// The file to write the time spent in each header, and the declarations
+  /// it introduced, to as JSON.
+  std::string HeaderCostOutputFile;
+
+  /// The file to write the #include directives of the main file that nothing
+  /// is used from to as JSON.
+  std::string UnusedIncludesOutputFile;
+
   /// The directory to copy module dependencies to when collecting them.
   std::string ModuleDependencyOutputDir;
 
@@ -291,6 +291,10 @@ public:
   /// Whether timestamps should be written to the produced PCH file.
   unsigned IncludeTimestamps : 1;
 
+  /// Whether headers are read with their comments and "#if 0" blocks
+  /// blanked out. Doc comments in headers are not available then.
+  unsigned MinimizeHeaders : 1;
+
   CodeCompleteOptions CodeCompleteOpts;
 
   /// Specifies the output format of the AST.
@@ -440,7 +444,8 @@ public:
         UseGlobalModuleIndex(true), GenerateGlobalModuleIndex(true),
         ASTDumpDecls(false), ASTDumpLookups(false),
         BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
-        IncludeTimestamps(true), IndexIgnoreSystemSymbols(false),
+        IncludeTimestamps(true), MinimizeHeaders(false),
+        IndexIgnoreSystemSymbols(false),
         IndexRecordCodegenName(false) {}
 
   /// getInputKindForExtension - Return the appropriate input kind for a file
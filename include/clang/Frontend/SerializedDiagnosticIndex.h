@@ -0,0 +1,109 @@
+//===- SerializedDiagnosticIndex.h - Merged serialized diagnostics -*- C++ -*-//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Loads the serialized diagnostics written by many compilations into memory,
+// merges and deduplicates them, and writes them back out as a single
+// diagnostics file with a file-to-diagnostics index.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_SERIALIZEDDIAGNOSTICINDEX_H
+#define LLVM_CLANG_FRONTEND_SERIALIZEDDIAGNOSTICINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/ErrorOr.h"
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace clang {
+namespace serialized_diags {
+
+/// A location read from serialized diagnostics, with its file resolved to a
+/// name. An empty file name denotes a diagnostic without a location.
+struct LoadedLocation {
+  std::string Filename;
+  unsigned Line = 0;
+  unsigned Col = 0;
+  unsigned Offset = 0;
+};
+
+/// A diagnostic read from serialized diagnostics, along with its notes.
+struct LoadedDiagnostic {
+  struct FixIt {
+    LoadedLocation Start;
+    LoadedLocation End;
+    std::string Text;
+  };
+
+  unsigned Severity = 0;
+  LoadedLocation Loc;
+  unsigned Category = 0;
+  std::string CategoryName;
+  std::string Flag;
+  std::string Message;
+  std::vector<std::pair<LoadedLocation, LoadedLocation>> Ranges;
+  std::vector<FixIt> FixIts;
+  std::vector<LoadedDiagnostic> Children;
+};
+
+/// Read all diagnostics in the serialized diagnostics file \p File.
+llvm::ErrorOr<std::vector<LoadedDiagnostic>> loadDiagnostics(StringRef File);
+
+/// Read the diagnostics located in \p SourceFile from the indexed serialized
+/// diagnostics file \p File, without reading any other diagnostics.
+///
+/// Falls back to reading the whole file if it has no index.
+llvm::ErrorOr<std::vector<LoadedDiagnostic>>
+loadDiagnosticsForFile(StringRef File, StringRef SourceFile);
+
+/// The deduplicated diagnostics of many serialized diagnostics files, grouped
+/// by the file of their location.
+class MergedDiagnostics {
+public:
+  /// Load \p Files on up to \p NumThreads threads (or one per hardware thread
+  /// if zero) and merge their diagnostics.
+  ///
+  /// A diagnostic that is identical to an earlier one, including its notes,
+  /// ranges and fix-its, is dropped; this is the common case for diagnostics
+  /// in headers that many translation units include.
+  static llvm::Expected<MergedDiagnostics> create(ArrayRef<std::string> Files,
+                                                  unsigned NumThreads = 0);
+
+  /// All diagnostics, grouped by file. Within a file, diagnostics keep the
+  /// order of the input files and of the diagnostics in them.
+  ArrayRef<LoadedDiagnostic> diagnostics() const { return Diagnostics; }
+
+  /// The diagnostics located in \p File.
+  ArrayRef<LoadedDiagnostic> getDiagnosticsForFile(StringRef File) const;
+
+  /// The number of diagnostics dropped as duplicates.
+  unsigned getNumDuplicates() const { return NumDuplicates; }
+
+  /// Write the merged diagnostics to \p OutputFile, along with an index that
+  /// \c loadDiagnosticsForFile uses.
+  std::error_code write(StringRef OutputFile) const;
+
+private:
+  std::vector<LoadedDiagnostic> Diagnostics;
+
+  /// The start and size of the run of each file's diagnostics.
+  llvm::StringMap<std::pair<unsigned, unsigned>> FileRanges;
+
+  unsigned NumDuplicates = 0;
+};
+
+} // namespace serialized_diags
+} // namespace clang
+
+#endif // LLVM_CLANG_FRONTEND_SERIALIZEDDIAGNOSTICINDEX_H
@@ -12,6 +12,7 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/Frontend/SerializedDiagnostics.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include <system_error>
 
 namespace llvm {
 class raw_ostream;
@@ -24,6 +25,8 @@ class DiagnosticOptions;
 
 namespace serialized_diags {
 
+struct LoadedDiagnostic;
+
 /// Returns a DiagnosticConsumer that serializes diagnostics to
 ///  a bitcode file.
 ///
@@ -36,6 +39,15 @@ std::unique_ptr<DiagnosticConsumer> create(StringRef OutputFile,
                                            DiagnosticOptions *Diags,
                                            bool MergeChildRecords = false);
 
+/// Write \p Diags to the bitcode file \p OutputFile, followed by an index
+/// that maps each file to the run of diagnostics located in it.
+///
+/// \p Diags must be grouped by the file of their location. Each run repeats
+/// the file, category and flag records it needs, so that a reader can jump
+/// straight to it.
+std::error_code writeIndexed(StringRef OutputFile,
+                             ArrayRef<LoadedDiagnostic> Diags);
+
 } // end serialized_diags namespace
 } // end clang namespace
 
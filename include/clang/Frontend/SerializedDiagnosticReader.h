@@ -14,6 +14,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorOr.h"
 #include <system_error>
+#include <utility>
 
 namespace clang {
 namespace serialized_diags {
@@ -31,6 +32,8 @@ enum class SDError {
   MissingVersion,
   VersionMismatch,
   UnsupportedConstruct,
+  /// The diagnostics file has no index block.
+  MissingIndex,
   /// A generic error for subclass handlers that don't want or need to define
   /// their own error_category.
   HandlerFailed
@@ -65,9 +68,20 @@ public:
   /// Read the diagnostics in \c File
   std::error_code readDiagnostics(StringRef File);
 
+  /// Read only the diagnostics in \c File that are located in \c SourceFile,
+  /// using the index block of a file written by
+  /// \c serialized_diags::writeIndexed.
+  ///
+  /// Returns \c SDError::MissingIndex if \c File has no index block; callers
+  /// can then fall back to \c readDiagnostics.
+  std::error_code readDiagnosticsForFile(StringRef File, StringRef SourceFile);
+
 private:
   enum class Cursor;
 
+  /// Check the signature at the start of \c Stream.
+  std::error_code readSignature(llvm::BitstreamCursor &Stream);
+
   /// Read to the next record or block to process.
   llvm::ErrorOr<Cursor> skipUntilRecordOrBlock(llvm::BitstreamCursor &Stream,
                                                unsigned &BlockOrRecordId);
@@ -78,6 +92,20 @@ private:
   /// Read a diagnostic block from \c Stream.
   std::error_code readDiagnosticBlock(llvm::BitstreamCursor &Stream);
 
+  /// Read an index block from \c Stream, looking for the entry for
+  /// \c SourceFile.
+  ///
+  /// \returns the bit offset of the first diagnostic located in
+  /// \c SourceFile and the number of diagnostics located there, or
+  /// (0, 0) if it has none.
+  llvm::ErrorOr<std::pair<uint64_t, unsigned>>
+  readIndexBlock(llvm::BitstreamCursor &Stream, StringRef SourceFile);
+
+  /// Read an index location block from \c Stream.
+  ///
+  /// \returns the bit offset of the index block.
+  llvm::ErrorOr<uint64_t> readIndexLocationBlock(llvm::BitstreamCursor &Stream);
+
 protected:
   /// Visit the start of a diagnostic block.
   virtual std::error_code visitStartOfDiagnostic() { return {}; }
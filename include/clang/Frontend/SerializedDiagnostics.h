@@ -21,7 +21,16 @@ enum BlockIDs {
 
   /// The this block acts as a container for all the information
   /// for a specific diagnostic.
-  BLOCK_DIAG
+  BLOCK_DIAG,
+
+  /// An optional top-level block, written after all diagnostics, that maps
+  /// each file to the run of diagnostics located in it. Readers that do not
+  /// know about it skip it.
+  BLOCK_INDEX,
+
+  /// An optional top-level block, written before all diagnostics, that
+  /// records where the index block starts.
+  BLOCK_INDEX_LOCATION
 };
 
 enum RecordIDs {
@@ -36,6 +45,14 @@ enum RecordIDs {
   RECORD_LAST = RECORD_FIXIT
 };
 
+enum IndexRecordIDs {
+  /// The bit offset of the first diagnostic located in a file, the number of
+  /// consecutive top-level diagnostics located in it, and the file name.
+  RECORD_INDEX_FILE = 1,
+  /// The bit offset of the index block, as a little-endian 64-bit blob.
+  RECORD_INDEX_LOCATION
+};
+
 /// A stable version of DiagnosticIDs::Level.
 ///
 /// Do not change the order of values in this enum, and please increment the
@@ -44,6 +44,7 @@ class ArgList;
 
 namespace clang {
 
+class ASTConsumer;
 class ASTReader;
 class CompilerInstance;
 class CompilerInvocation;
@@ -187,6 +188,20 @@ public:
 void AttachDependencyGraphGen(Preprocessor &PP, StringRef OutputFile,
                               StringRef SysRoot);
 
+/// CreateHeaderCostReporter - Create a consumer that measures the time spent
+/// in every header the main file of \p PP includes and counts the
+/// declarations each of them introduces, and writes both to \p OutputFile as
+/// JSON at the end of the translation unit.
+std::unique_ptr<ASTConsumer> CreateHeaderCostReporter(Preprocessor &PP,
+                                                      StringRef OutputFile);
+
+/// CreateUnusedIncludeReporter - Create a consumer that finds the #include
+/// directives of the main file of \p PP that nothing is used from, warns
+/// about them with -Wunused-include and, unless \p OutputFile is empty,
+/// writes them to it as JSON at the end of the translation unit.
+std::unique_ptr<ASTConsumer> CreateUnusedIncludeReporter(Preprocessor &PP,
+                                                         StringRef OutputFile);
+
 /// AttachHeaderIncludeGen - Create a header include list generator, and attach
 /// it to the given preprocessor.
 ///
@@ -211,6 +226,21 @@ IntrusiveRefCntPtr<ExternalSemaSource>
 createChainedIncludesSource(CompilerInstance &CI,
                             IntrusiveRefCntPtr<ExternalSemaSource> &Reader);
 
+/// Wrap \p FS so that the headers read through it have their comments and
+/// "#if 0" blocks blanked out, as \c blankOutCommentsAndDisabledBlocks does.
+/// Offsets, lines and columns in the headers stay the same.
+///
+/// The files in \p MainFiles, and files that do not look like headers, are
+/// read unchanged. The blanked out headers are cached for the whole process
+/// and reused as long as the size and modification time of the file match.
+///
+/// \param LineComments Whether "//" starts a comment in the language mode.
+/// \param RawStringLiterals Whether the language mode has raw string literals.
+IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+createMinimizedHeaderFileSystem(IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+                                ArrayRef<std::string> MainFiles,
+                                bool LineComments, bool RawStringLiterals);
+
 /// createInvocationFromCommandLine - Construct a compiler invocation object for
 /// a command line argument vector.
 ///
@@ -105,6 +105,27 @@ bool minimizeSourceToDependencyDirectives(
     DiagnosticsEngine *Diags = nullptr,
     SourceLocation InputSourceLoc = SourceLocation());
 
+/// Replace the comments in \p Input, and the contents of any "#if 0" blocks,
+/// with whitespace, so that lexing the output for a full compilation is
+/// cheaper.
+///
+/// Unlike \c minimizeSourceToDependencyDirectives, this keeps all the code.
+/// The output has the same size as the input and keeps its newlines and line
+/// continuations, so offsets, lines and columns in it are the same as in the
+/// input. Comments in preprocessor directives that span lines are kept, since
+/// blanking them would end the directive early.
+///
+/// \param LineComments Whether "//" starts a comment in the language mode.
+/// \param RawStringLiterals Whether the language mode has C++11 raw string
+/// literals.
+///
+/// \returns false on success, true if the input has a construct this cannot
+/// handle; the output should not be used then.
+bool blankOutCommentsAndDisabledBlocks(llvm::StringRef Input,
+                                       llvm::SmallVectorImpl<char> &Output,
+                                       bool LineComments = true,
+                                       bool RawStringLiterals = true);
+
 } // end namespace clang
 
 #endif // LLVM_CLANG_LEX_DEPENDENCY_DIRECTIVES_SOURCE_MINIMIZER_H
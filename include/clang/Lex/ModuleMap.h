@@ -285,6 +285,11 @@ private:
   /// map.
   llvm::DenseMap<const FileEntry *, bool> ParsedModuleMap;
 
+  /// The number of module map files parsed, and how many of them were
+  /// parsed from the tokens of an earlier parse of the same contents.
+  unsigned NumModuleMapFilesParsed = 0;
+  unsigned NumModuleMapFilesReplayed = 0;
+
   /// Resolve the given export declaration into an actual export
   /// declaration.
   ///
@@ -691,6 +696,10 @@ public:
   /// Dump the contents of the module map, for debugging purposes.
   void dump();
 
+  /// Print some statistics to stderr that indicate how well module map files
+  /// are being parsed.
+  void PrintStats();
+
   using module_iterator = llvm::StringMap<Module *>::const_iterator;
 
   module_iterator module_begin() const { return Modules.begin(); }
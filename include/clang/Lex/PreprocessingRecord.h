@@ -312,6 +312,13 @@ class Token;
     /// were seen.
     std::vector<PreprocessedEntity *> PreprocessedEntities;
 
+    /// The source ranges of the entities in \c PreprocessedEntities, at the
+    /// same indices.
+    ///
+    /// Range queries binary search this array, so they do not have to
+    /// dereference an entity at every step.
+    std::vector<SourceRange> PreprocessedEntityRanges;
+
     /// The set of preprocessed entities in this record that have been
     /// loaded from external sources.
     ///
@@ -41,6 +41,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/iterator_range.h"
@@ -776,6 +777,15 @@ private:
   llvm::DenseMap<IdentifierInfo *, std::vector<MacroInfo *>>
       PragmaPushMacroInfo;
 
+  /// The tokens formed by token pasting, keyed by the concatenated spelling
+  /// of the pasted tokens.
+  ///
+  /// Their locations point into the scratch buffer, which lives as long as
+  /// the SourceManager, so pasting the same spellings again can reuse the
+  /// result instead of copying the spelling into the scratch buffer and
+  /// relexing it.
+  llvm::StringMap<Token> PasteResultCache;
+
   // Various statistics we track for performance analysis.
   unsigned NumDirectives = 0;
   unsigned NumDefined = 0;
@@ -792,7 +802,9 @@ private:
   unsigned NumFastMacroExpanded = 0;
   unsigned NumTokenPaste = 0;
   unsigned NumFastTokenPaste = 0;
+  unsigned NumCachedTokenPaste = 0;
   unsigned NumSkipped = 0;
+  unsigned NumSkippedWithoutLexing = 0;
 
   /// The predefined macros that preprocessor should use from the
   /// command line etc.
@@ -1819,6 +1831,21 @@ public:
       ++NumTokenPaste;
   }
 
+  /// Returns the token that an earlier paste of tokens spelled \p Spelling
+  /// formed, or null if there was none.
+  const Token *getCachedPasteResult(StringRef Spelling) {
+    auto Known = PasteResultCache.find(Spelling);
+    if (Known == PasteResultCache.end())
+      return nullptr;
+    ++NumCachedTokenPaste;
+    return &Known->second;
+  }
+
+  /// Remembers that pasting tokens spelled \p Spelling formed \p Result.
+  void cachePasteResult(StringRef Spelling, const Token &Result) {
+    PasteResultCache.insert({Spelling, Result});
+  }
+
   void PrintStats();
 
   size_t getTotalMemory() const;
@@ -2326,10 +2353,20 @@ private:
   Optional<unsigned>
   getSkippedRangeForExcludedConditionalBlock(SourceLocation HashLoc);
 
+  /// Returns the process-wide skip mapping for the file \p FID, or null if
+  /// it should not be used in this compilation.
+  SharedSkippedRangeCache::FileRanges *getSharedSkippedRanges(FileID FID);
+
   /// Contains the currently active skipped range mappings for skipping excluded
   /// conditional directives.
   ExcludedPreprocessorDirectiveSkipMapping
       *ExcludedConditionalDirectiveSkipMappings;
+
+  /// The process-wide skip mappings of the buffers that excluded conditional
+  /// blocks were skipped in, when there are no active skipped range mappings.
+  llvm::DenseMap<const llvm::MemoryBuffer *,
+                 SharedSkippedRangeCache::FileRanges *>
+      SharedSkippedRanges;
 };
 
 /// Abstract base class that describes a handler that will receive
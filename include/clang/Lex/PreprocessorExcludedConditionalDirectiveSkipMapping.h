@@ -12,6 +12,9 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <mutex>
+#include <utility>
 
 namespace clang {
 
@@ -26,6 +29,36 @@ using ExcludedPreprocessorDirectiveSkipMapping =
     llvm::DenseMap<const llvm::MemoryBuffer *,
                    const PreprocessorSkippedRangeMapping *>;
 
+/// The skip mappings that preprocessors learn while skipping excluded
+/// conditional blocks, shared by all the compilations in the process, so
+/// that a block that one compilation lexed through can be skipped over by
+/// the others.
+///
+/// A mapping is only valid for the exact contents of a file, lexed with the
+/// same lexing-related language options; together, these form its key.
+class SharedSkippedRangeCache {
+public:
+  /// The skip mapping of one file, which can be used concurrently.
+  class FileRanges {
+    std::mutex Lock;
+    PreprocessorSkippedRangeMapping Ranges;
+
+  public:
+    /// Returns the number of bytes from the '#' of the conditional directive
+    /// at \p Offset to the '#' of the next directive of the same conditional,
+    /// or 0 if that is not known.
+    unsigned lookup(unsigned Offset);
+
+    void add(unsigned Offset, unsigned Length);
+  };
+
+  using KeyTy = std::pair<uint64_t, uint64_t>;
+
+  /// Returns the skip mapping for the file with key \p Key. Entries are never
+  /// removed, so the result stays valid for the lifetime of the process.
+  static FileRanges &getFileRanges(KeyTy Key);
+};
+
 } // end namespace clang
 
 #endif // LLVM_CLANG_LEX_PREPROCESSOR_EXCLUDED_COND_DIRECTIVE_SKIP_MAPPING_H
@@ -15,7 +15,9 @@
 #define LLVM_CLANG_REWRITE_CORE_HTMLREWRITE_H
 
 #include "clang/Basic/SourceLocation.h"
+#include <map>
 #include <string>
+#include <vector>
 
 namespace clang {
 
@@ -65,15 +67,33 @@ namespace html {
   void AddHeaderFooterInternalBuiltinCSS(Rewriter &R, FileID FID,
                                          StringRef title);
 
+  /// HighlightCache - The tags that SyntaxHighlight and HighlightMacros
+  /// insert into files, which lets further rewrites of the same files insert
+  /// them again without relexing the files.
+  struct HighlightCache {
+    struct Highlight {
+      unsigned B, E;
+      std::string StartTag, EndTag;
+    };
+    using HighlightList = std::vector<Highlight>;
+
+    std::map<FileID, HighlightList> SyntaxHighlights;
+    std::map<FileID, HighlightList> MacroHighlights;
+  };
+
   /// SyntaxHighlight - Relex the specified FileID and annotate the HTML with
-  /// information about keywords, comments, etc.
-  void SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP);
+  /// information about keywords, comments, etc. If \p Cache is given, the
+  /// annotations are taken from it if the file was highlighted before, and
+  /// recorded in it otherwise.
+  void SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP,
+                       HighlightCache *Cache = nullptr);
 
   /// HighlightMacros - This uses the macro table state from the end of the
   /// file, to reexpand macros and insert (into the HTML) information about the
   /// macro expansions.  This won't be perfectly perfect, but it will be
-  /// reasonably close.
-  void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP);
+  /// reasonably close. \p Cache is used like in SyntaxHighlight.
+  void HighlightMacros(Rewriter &R, FileID FID, const Preprocessor &PP,
+                       HighlightCache *Cache = nullptr);
 
 } // end html namespace
 } // end clang namespace
@@ -1211,6 +1211,10 @@ private:
   serialization::InputFile getInputFile(ModuleFile &F, unsigned ID,
                                         bool Complain = true);
 
+  /// Stat the first \p NumInputs input files of \p F that have not been
+  /// looked up yet in parallel, ahead of validating them one by one.
+  void prefetchInputFileStats(ModuleFile &F, unsigned NumInputs);
+
 public:
   void ResolveImportedPath(ModuleFile &M, std::string &Filename);
   static void ResolveImportedPath(std::string &Filename, StringRef Prefix);
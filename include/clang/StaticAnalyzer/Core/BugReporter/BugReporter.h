@@ -59,7 +59,9 @@ class ExplodedGraph;
 class ExplodedNode;
 class ExprEngine;
 class MemRegion;
+class RefutationSolver;
 class SValBuilder;
+class TrimmedExplodedGraph;
 
 //===----------------------------------------------------------------------===//
 // Interface for individual bug reports.
@@ -512,6 +514,15 @@ private:
 class GRBugReporter : public BugReporter {
   ExprEngine& Eng;
 
+  /// The exploded graph trimmed to the paths to the error nodes of all the
+  /// reports, which is built by the first path generation and shared by the
+  /// rest.
+  std::unique_ptr<TrimmedExplodedGraph> TrimmedGraphForAllReports;
+
+  /// The solver that checks the constraints of the report paths when they
+  /// are crosschecked, which is created on first use.
+  std::unique_ptr<RefutationSolver> Refutation;
+
 public:
   GRBugReporter(BugReporterData& d, ExprEngine& eng)
       : BugReporter(d, GRBugReporterKind), Eng(eng) {}
@@ -526,6 +537,9 @@ public:
   ///  engine.
   ProgramStateManager &getStateManager();
 
+  /// Returns the solver that refutes the reports with infeasible paths.
+  RefutationSolver &getRefutationSolver();
+
   /// \p bugReports A set of bug reports within a *single* equivalence class
   ///
   /// \return A mapping from consumers to the corresponding diagnostics.
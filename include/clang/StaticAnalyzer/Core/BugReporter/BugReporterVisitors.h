@@ -18,13 +18,18 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/RangedConstraintManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SVals.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/SMTAPI.h"
 #include <memory>
 
 namespace clang {
 
+class ASTContext;
 class BinaryOperator;
 class CFGBlock;
 class DeclRefExpr;
@@ -313,17 +318,48 @@ public:
                                                  BugReport &BR) override;
 };
 
+/// Checks the constraints collected along bug report paths with an SMT
+/// solver, reusing the work done for earlier paths of the same bug reporter.
+///
+/// The paths to different reports usually start out the same way, so the
+/// constraints of each step of the last path checked stay asserted in a
+/// solver scope of their own, and only the scopes past the point where the
+/// next path diverges are popped. The results are also cached by the
+/// constraints of the whole path, which are canonical within a program state
+/// manager.
+class RefutationSolver {
+  llvm::SMTSolverRef Solver;
+
+  /// The constraints of the steps of the last path checked, from the root
+  /// down.
+  SmallVector<ConstraintRangeTy, 32> Scopes;
+
+  /// The results of earlier queries, keyed by the root of the constraints of
+  /// the path, which the value keeps alive.
+  llvm::DenseMap<const void *, std::pair<ConstraintRangeTy, Optional<bool>>>
+      Results;
+
+public:
+  explicit RefutationSolver(
+      llvm::SMTSolverRef Solver = llvm::CreateZ3Solver());
+
+  /// Returns whether the constraints along a path are satisfiable, or None if
+  /// the solver cannot tell. \p Steps are the distinct constraints along the
+  /// path from the error node up to the root, and \p Constraints are the
+  /// tightest ones on each symbol among them.
+  Optional<bool> check(ASTContext &Ctx, ArrayRef<ConstraintRangeTy> Steps,
+                       ConstraintRangeTy Constraints);
+};
+
 /// The bug visitor will walk all the nodes in a path and collect all the
-/// constraints. When it reaches the root node, will create a refutation
-/// manager and check if the constraints are satisfiable
+/// constraints. When it reaches the root node, it checks if the constraints
+/// are satisfiable with the refutation solver of the bug reporter.
 class FalsePositiveRefutationBRVisitor final : public BugReporterVisitor {
 private:
-  /// Holds the constraints in a given path
-  ConstraintRangeTy Constraints;
+  /// The distinct constraints along the path, from the error node up.
+  SmallVector<ConstraintRangeTy, 32> Steps;
 
 public:
-  FalsePositiveRefutationBRVisitor();
-
   void Profile(llvm::FoldingSetNodeID &ID) const override;
 
   std::shared_ptr<PathDiagnosticPiece> VisitNode(const ExplodedNode *N,
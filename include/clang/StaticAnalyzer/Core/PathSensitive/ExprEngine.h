@@ -267,6 +267,14 @@ public:
             const Stmt *DiagnosticStmt = nullptr,
             ProgramPoint::Kind K = ProgramPoint::PreStmtPurgeDeadSymbolsKind);
 
+  /// Removes the bindings of the expressions that are no longer live at
+  /// \p ReferenceStmt, without scanning the store or asking the checkers
+  /// about dead symbols. Used between the full collections of the block purge
+  /// mode. The node is reused if nothing was removed.
+  void removeDeadExpressions(ExplodedNode *Node, ExplodedNodeSet &Out,
+                             const Stmt *ReferenceStmt,
+                             const LocationContext *LC);
+
   /// processCFGElement - Called by CoreEngine. Used to generate new successor
   ///  nodes by processing the 'effects' of a CFG element.
   void processCFGElement(const CFGElement E, ExplodedNode *Pred,
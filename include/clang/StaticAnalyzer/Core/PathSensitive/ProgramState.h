@@ -533,6 +533,13 @@ public:
                                     const StackFrameContext *LCtx,
                                     SymbolReaper& SymReaper);
 
+  /// Removes only the bindings of the expressions that are no longer live.
+  /// Unlike removeDeadBindings, the store and the constraints are left alone,
+  /// so the symbols that die this way are only reaped by the next full
+  /// collection.
+  ProgramStateRef removeDeadExpressionBindings(ProgramStateRef St,
+                                               SymbolReaper &SymReaper);
+
 public:
 
   SVal ArrayToPointer(Loc Array, QualType ElementTy) {
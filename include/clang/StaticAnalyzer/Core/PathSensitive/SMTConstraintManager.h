@@ -124,6 +124,7 @@ public:
           SMTConv::fromData(Solver, SD->getSymbolID(), Ty, Ctx.getTypeSize(Ty));
 
       Solver->reset();
+      AssertedConstraints = None;
       addStateConstraints(State);
 
       // Constraints are unsatisfiable
@@ -336,10 +337,20 @@ protected:
     if (I != Cached.end())
       return I->second;
 
-    Solver->reset();
-    addStateConstraints(NewState);
+    // The queries about one state tend to come in a row, like the two that
+    // checkNull() makes, so the constraints of the state stay asserted and
+    // the new constraint is checked in a scope of its own.
+    ConstraintSMTType Constraints = State->get<ConstraintSMT>();
+    if (!AssertedConstraints || *AssertedConstraints != Constraints) {
+      Solver->reset();
+      addStateConstraints(State);
+      AssertedConstraints = Constraints;
+    }
 
+    Solver->push();
+    Solver->addConstraint(Exp);
     Optional<bool> res = Solver->check();
+    Solver->pop();
     if (!res.hasValue())
       Cached[hash] = ConditionTruthVal();
     else
@@ -351,6 +362,10 @@ protected:
   // Cache the result of an SMT query (true, false, unknown). The key is the
   // hash of the constraints in a state
   mutable llvm::DenseMap<unsigned, ConditionTruthVal> Cached;
+
+  // The constraints of the state that are asserted in the outermost scope of
+  // the solver, if they are those of a state.
+  mutable Optional<ConstraintSMTType> AssertedConstraints;
 }; // end class SMTConstraintManager
 
 } // namespace ento
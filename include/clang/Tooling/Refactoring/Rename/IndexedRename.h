@@ -0,0 +1,59 @@
+//===--- IndexedRename.h - Clang refactoring library ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Provides functionality for finding the occurrences of symbols to rename in
+/// an index store, so that only the translation units the index cannot
+/// account for have to be parsed.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_REFACTOR_RENAME_INDEXED_RENAME_H
+#define LLVM_CLANG_TOOLING_REFACTOR_RENAME_INDEXED_RENAME_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Tooling/Core/Replacement.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Error.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+
+/// The renaming edits that could be computed from an index store.
+struct IndexedRenameEdits {
+  /// Replacements for the occurrences whose spelling was verified against the
+  /// source text, keyed by file path.
+  std::map<std::string, Replacements> FileToReplaces;
+
+  /// The main files of the translation units that still have to be parsed,
+  /// either because they contain occurrences that the index cannot rename
+  /// on its own (e.g. inside macros) or because their index data is stale.
+  std::vector<std::string> FilesToReparse;
+
+  /// The main files and headers that the index store has current data for.
+  llvm::StringSet<> IndexedFiles;
+};
+
+/// Finds the occurrences of the symbols in \p USRList in the index store at
+/// \p StorePath and computes the replacements that rename them from
+/// \p PrevNames to \p NewNames. The arguments have the same meaning as the
+/// ones of \c RenamingAction.
+llvm::Expected<IndexedRenameEdits>
+findIndexedRenameEdits(StringRef StorePath,
+                       const std::vector<std::string> &NewNames,
+                       const std::vector<std::string> &PrevNames,
+                       const std::vector<std::vector<std::string>> &USRList,
+                       bool PrintLocations = false);
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif // LLVM_CLANG_TOOLING_REFACTOR_RENAME_INDEXED_RENAME_H
@@ -27,8 +27,12 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include <mutex>
 #include <sys/stat.h>
 
 using namespace clang;
@@ -47,6 +51,8 @@ STATISTIC(NumDirectoriesSearched,
           "header directories searched");
 STATISTIC(NumDirectoryCacheHits,
           "directory cache hits");
+STATISTIC(NumCompiledCacheHits,
+          "API notes files whose compiled form was reused");
 
 namespace {
   /// Prints two successive strings, which much be kept alive as long as the
@@ -60,6 +66,71 @@ namespace {
       OS << First << Second;
     }
   };
+
+  /// The compiled, binary form of API notes files, shared by all API notes
+  /// managers in the process so that batch and daemon builds compile each
+  /// API notes file only once. The readers of all managers look up entities
+  /// directly in these buffers.
+  ///
+  /// Entries are never evicted, since readers may point into them for as long
+  /// as the process lives. An API notes file that is edited while a
+  /// long-lived process such as libclang runs therefore keeps the compiled
+  /// form of each of its versions in memory.
+  class CompiledAPINotesCache {
+    std::mutex Mutex;
+    llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> Buffers;
+
+  public:
+    llvm::MemoryBuffer *lookup(StringRef key) {
+      std::lock_guard<std::mutex> lock(Mutex);
+      auto known = Buffers.find(key);
+      return known == Buffers.end() ? nullptr : known->second.get();
+    }
+
+    /// Add the compiled form of an API notes file, and return the buffer for
+    /// it, which might have been added concurrently by another thread.
+    llvm::MemoryBuffer *insert(StringRef key,
+                               std::unique_ptr<llvm::MemoryBuffer> buffer) {
+      std::lock_guard<std::mutex> lock(Mutex);
+      return Buffers.try_emplace(key, std::move(buffer)).first->second.get();
+    }
+  };
+
+  /// Observes whether compiling API notes produced any diagnostics, which
+  /// would be lost if the compiled form were reused.
+  struct DiagnosticObserver {
+    llvm::SourceMgr::DiagHandlerTy Handler;
+    void *Context;
+    bool SawDiagnostic = false;
+
+    DiagnosticObserver(llvm::SourceMgr::DiagHandlerTy handler, void *context)
+        : Handler(handler), Context(context) {}
+
+    static void handleDiag(const llvm::SMDiagnostic &diag, void *context) {
+      auto *self = static_cast<DiagnosticObserver *>(context);
+      self->SawDiagnostic = true;
+      self->Handler(diag, self->Context);
+    }
+  };
+}
+
+static llvm::ManagedStatic<CompiledAPINotesCache> CompiledCache;
+
+/// Compute the key for the compiled form of the API notes \p source, read
+/// from \p sourceFile, whose size and modification time the compiled form
+/// records.
+static std::string getCompiledCacheKey(StringRef source,
+                                       const FileEntry *sourceFile) {
+  llvm::MD5 hash;
+  hash.update(source);
+  llvm::MD5::MD5Result result;
+  hash.final(result);
+
+  std::string key = result.digest().str();
+  llvm::raw_string_ostream OS(key);
+  OS << ':' << sourceFile->getSize() << ':'
+     << sourceFile->getModificationTime();
+  return OS.str();
 }
 
 APINotesManager::APINotesManager(SourceManager &sourceMgr,
@@ -88,6 +159,15 @@ APINotesManager::loadAPINotes(const FileEntry *apiNotesFile) {
   auto sourceBuffer = SourceMgr.getBuffer(sourceFileID, SourceLocation());
   if (!sourceBuffer) return nullptr;
 
+  // Reuse the compiled form if another compiler instance in this process
+  // already compiled the same API notes.
+  std::string cacheKey = getCompiledCacheKey(sourceBuffer->getBuffer(),
+                                             apiNotesFile);
+  if (llvm::MemoryBuffer *compiled = CompiledCache->lookup(cacheKey)) {
+    ++NumCompiledCacheHits;
+    return APINotesReader::getUnmanaged(compiled, SwiftVersion);
+  }
+
   // Compile the API notes source into a buffer.
   // FIXME: Either propagate OSType through or, better yet, improve the binary
   // APINotes format to maintain complete availability information.
@@ -101,17 +181,27 @@ APINotesManager::loadAPINotes(const FileEntry *apiNotesFile) {
                                    diag::warn_apinotes_message,
                                    diag::note_apinotes_message,
                                    apiNotesFile);
+    DiagnosticObserver observer(srcMgrAdapter.getDiagHandler(),
+                                srcMgrAdapter.getDiagContext());
     llvm::raw_svector_ostream OS(apiNotesBuffer);
     if (api_notes::compileAPINotes(sourceBuffer->getBuffer(),
                                    SourceMgr.getFileEntryForID(sourceFileID),
                                    OS,
-                                   srcMgrAdapter.getDiagHandler(),
-                                   srcMgrAdapter.getDiagContext()))
+                                   &DiagnosticObserver::handleDiag,
+                                   &observer))
       return nullptr;
 
     // Make a copy of the compiled form into the buffer.
     compiledBuffer = llvm::MemoryBuffer::getMemBufferCopy(
                StringRef(apiNotesBuffer.data(), apiNotesBuffer.size()));
+
+    // Share the compiled form, unless later compiles need to diagnose the
+    // API notes again.
+    if (!observer.SawDiagnostic) {
+      llvm::MemoryBuffer *shared =
+          CompiledCache->insert(cacheKey, std::move(compiledBuffer));
+      return APINotesReader::getUnmanaged(shared, SwiftVersion);
+    }
   }
 
   // Load the binary form we just compiled.
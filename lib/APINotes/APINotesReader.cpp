@@ -1495,6 +1495,10 @@ ModuleOptions APINotesReader::getModuleOptions() const {
   return Impl.ModuleOpts;
 }
 
+const llvm::MemoryBuffer &APINotesReader::getBuffer() const {
+  return *Impl.InputBuffer;
+}
+
 template<typename T>
 APINotesReader::VersionedInfo<T>::VersionedInfo(
     VersionTuple version,
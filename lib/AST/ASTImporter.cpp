@@ -2024,6 +2024,7 @@ bool ASTNodeImporter::IsStructuralMatch(Decl *From, Decl *To, bool Complain) {
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), getStructuralEquivalenceKind(Importer),
       false, Complain);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(From, To);
 }
 
@@ -2043,6 +2044,7 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
                                    Importer.getNonEquivalentDecls(),
                                    getStructuralEquivalenceKind(Importer),
                                    false, Complain);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(FromRecord, ToRecord);
 }
 
@@ -2052,6 +2054,7 @@ bool ASTNodeImporter::IsStructuralMatch(VarDecl *FromVar, VarDecl *ToVar,
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), getStructuralEquivalenceKind(Importer),
       false, Complain);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(FromVar, ToVar);
 }
 
@@ -2065,6 +2068,7 @@ bool ASTNodeImporter::IsStructuralMatch(EnumDecl *FromEnum, EnumDecl *ToEnum) {
   StructuralEquivalenceContext Ctx(
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), getStructuralEquivalenceKind(Importer));
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(FromEnum, ToEnum);
 }
 
@@ -2074,6 +2078,7 @@ bool ASTNodeImporter::IsStructuralMatch(FunctionTemplateDecl *From,
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), getStructuralEquivalenceKind(Importer),
       false, false);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(From, To);
 }
 
@@ -2082,6 +2087,7 @@ bool ASTNodeImporter::IsStructuralMatch(FunctionDecl *From, FunctionDecl *To) {
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), getStructuralEquivalenceKind(Importer),
       false, false);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(From, To);
 }
 
@@ -2101,6 +2107,7 @@ bool ASTNodeImporter::IsStructuralMatch(ClassTemplateDecl *From,
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls(),
                                    getStructuralEquivalenceKind(Importer));
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(From, To);
 }
 
@@ -2110,6 +2117,7 @@ bool ASTNodeImporter::IsStructuralMatch(VarTemplateDecl *From,
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls(),
                                    getStructuralEquivalenceKind(Importer));
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsEquivalent(From, To);
 }
 
@@ -8811,5 +8819,6 @@ bool ASTImporter::IsStructurallyEquivalent(QualType From, QualType To,
   StructuralEquivalenceContext Ctx(FromContext, ToContext, NonEquivalentDecls,
                                    getStructuralEquivalenceKind(*this), false,
                                    Complain);
+  Ctx.EquivalentDecls = &EquivalentDecls;
   return Ctx.IsEquivalent(From, To);
 }
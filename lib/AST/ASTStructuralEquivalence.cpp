@@ -1495,6 +1495,12 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
           std::make_pair(D1->getCanonicalDecl(), D2->getCanonicalDecl())))
     return false;
 
+  // Check whether an earlier check proved them equivalent.
+  if (Context.EquivalentDecls &&
+      Context.EquivalentDecls->count(
+          std::make_pair(D1->getCanonicalDecl(), D2->getCanonicalDecl())))
+    return true;
+
   // Determine whether we've already produced a tentative equivalence for D1.
   Decl *&EquivToD1 = Context.TentativeEquivalences[D1->getCanonicalDecl()];
   if (EquivToD1)
@@ -1627,7 +1633,11 @@ bool StructuralEquivalenceContext::IsEquivalent(Decl *D1, Decl *D2) {
   if (!::IsStructurallyEquivalent(*this, D1, D2))
     return false;
 
-  return !Finish();
+  if (Finish())
+    return false;
+
+  recordEquivalences();
+  return true;
 }
 
 bool StructuralEquivalenceContext::IsEquivalent(QualType T1, QualType T2) {
@@ -1636,7 +1646,11 @@ bool StructuralEquivalenceContext::IsEquivalent(QualType T1, QualType T2) {
   if (!::IsStructurallyEquivalent(*this, T1, T2))
     return false;
 
-  return !Finish();
+  if (Finish())
+    return false;
+
+  recordEquivalences();
+  return true;
 }
 
 bool StructuralEquivalenceContext::CheckCommonEquivalence(Decl *D1, Decl *D2) {
@@ -1780,6 +1794,38 @@ bool StructuralEquivalenceContext::CheckKindSpecificEquivalence(
   return true;
 }
 
+/// Whether the structural equivalence of \p D with another declaration can
+/// no longer change, because it has no definition still to come.
+static bool hasStableEquivalence(Decl *D) {
+  if (auto *Tag = dyn_cast<TagDecl>(D))
+    return Tag->getDefinition() != nullptr;
+  if (auto *Template = dyn_cast<ClassTemplateDecl>(D))
+    return Template->getTemplatedDecl()->getDefinition() != nullptr;
+  if (auto *Interface = dyn_cast<ObjCInterfaceDecl>(D))
+    return Interface->hasDefinition();
+  if (auto *Protocol = dyn_cast<ObjCProtocolDecl>(D))
+    return Protocol->hasDefinition();
+  return true;
+}
+
+void StructuralEquivalenceContext::recordEquivalences() {
+  // A minimal or spelling-sensitive check proves less than a default one.
+  if (!EquivalentDecls || EqKind != StructuralEquivalenceKind::Default ||
+      StrictTypeSpelling)
+    return;
+
+  // Incomplete declarations are assumed to be equivalent to anything, and
+  // every equivalence in this context may depend on such an assumption, which
+  // completing the declaration can invalidate.
+  for (const auto &Pair : TentativeEquivalences)
+    if (!hasStableEquivalence(Pair.first) ||
+        !hasStableEquivalence(Pair.second))
+      return;
+
+  for (const auto &Pair : TentativeEquivalences)
+    EquivalentDecls->insert(std::make_pair(Pair.first, Pair.second));
+}
+
 bool StructuralEquivalenceContext::Finish() {
   while (!DeclsToCheck.empty()) {
     // Check the next declaration.
@@ -174,23 +174,35 @@ public:
 /// locks, so we can get away with doing a linear search for lookup.  Note
 /// that a hashtable or map is inappropriate in this case, because lookups
 /// may involve partial pattern matches, rather than exact matches.
+///
+/// Most blocks hand the set they start with on to their successors
+/// unchanged, so copies share the indices until one of them is modified.
 class FactSet {
 private:
   using FactVec = SmallVector<FactID, 4>;
 
-  FactVec FactIDs;
+  /// The indices of the facts, or null if the set is empty.
+  std::shared_ptr<FactVec> FactIDs;
+
+  /// Returns the indices of this set, after making a copy of them if they
+  /// are shared with another set.
+  FactVec &getMutableFactIDs() {
+    if (!FactIDs)
+      FactIDs = std::make_shared<FactVec>();
+    else if (FactIDs.use_count() > 1)
+      FactIDs = std::make_shared<FactVec>(*FactIDs);
+    return *FactIDs;
+  }
 
 public:
-  using iterator = FactVec::iterator;
   using const_iterator = FactVec::const_iterator;
 
-  iterator begin() { return FactIDs.begin(); }
-  const_iterator begin() const { return FactIDs.begin(); }
-
-  iterator end() { return FactIDs.end(); }
-  const_iterator end() const { return FactIDs.end(); }
+  const_iterator begin() const {
+    return FactIDs ? FactIDs->begin() : nullptr;
+  }
+  const_iterator end() const { return FactIDs ? FactIDs->end() : nullptr; }
 
-  bool isEmpty() const { return FactIDs.size() == 0; }
+  bool isEmpty() const { return !FactIDs || FactIDs->empty(); }
 
   // Return true if the set contains only negative facts
   bool isEmpty(FactManager &FactMan) const {
@@ -201,37 +213,42 @@ public:
     return true;
   }
 
-  void addLockByID(FactID ID) { FactIDs.push_back(ID); }
+  /// Returns true if this set is a copy of \p Other that neither of them
+  /// modified since, which means that they hold the same facts.
+  bool isUnmodifiedCopyOf(const FactSet &Other) const {
+    return FactIDs == Other.FactIDs;
+  }
+
+  void addLockByID(FactID ID) { getMutableFactIDs().push_back(ID); }
 
   FactID addLock(FactManager &FM, std::unique_ptr<FactEntry> Entry) {
     FactID F = FM.newFact(std::move(Entry));
-    FactIDs.push_back(F);
+    getMutableFactIDs().push_back(F);
     return F;
   }
 
   bool removeLock(FactManager& FM, const CapabilityExpr &CapE) {
-    unsigned n = FactIDs.size();
-    if (n == 0)
+    // Look the fact up first, so that the indices are not copied for nothing.
+    const_iterator I = std::find_if(begin(), end(), [&](FactID ID) {
+      return FM[ID].matches(CapE);
+    });
+    if (I == end())
       return false;
 
-    for (unsigned i = 0; i < n-1; ++i) {
-      if (FM[FactIDs[i]].matches(CapE)) {
-        FactIDs[i] = FactIDs[n-1];
-        FactIDs.pop_back();
-        return true;
-      }
-    }
-    if (FM[FactIDs[n-1]].matches(CapE)) {
-      FactIDs.pop_back();
-      return true;
-    }
-    return false;
+    unsigned Index = I - begin();
+    FactVec &IDs = getMutableFactIDs();
+    IDs[Index] = IDs.back();
+    IDs.pop_back();
+    return true;
   }
 
-  iterator findLockIter(FactManager &FM, const CapabilityExpr &CapE) {
-    return std::find_if(begin(), end(), [&](FactID ID) {
-      return FM[ID].matches(CapE);
+  /// Replaces the fact that matches \p CapE with the fact \p ID.
+  void replaceLock(FactManager &FM, const CapabilityExpr &CapE, FactID ID) {
+    const_iterator I = std::find_if(begin(), end(), [&](FactID F) {
+      return FM[F].matches(CapE);
     });
+    if (I != end())
+      getMutableFactIDs()[I - begin()] = ID;
   }
 
   const FactEntry *findLock(FactManager &FM, const CapabilityExpr &CapE) const {
@@ -2188,14 +2205,17 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
                                             LockErrorKind LEK1,
                                             LockErrorKind LEK2,
                                             bool Modify) {
+  // Both sides hold the very same facts, so nothing conflicts and nothing is
+  // removed.
+  if (FSet1.isUnmodifiedCopyOf(FSet2))
+    return;
+
   FactSet FSet1Orig = FSet1;
 
   // Find locks in FSet2 that conflict or are not in FSet1, and warn.
   for (const auto &Fact : FSet2) {
-    const FactEntry *LDat1 = nullptr;
     const FactEntry *LDat2 = &FactMan[Fact];
-    FactSet::iterator Iter1  = FSet1.findLockIter(FactMan, *LDat2);
-    if (Iter1 != FSet1.end()) LDat1 = &FactMan[*Iter1];
+    const FactEntry *LDat1 = FSet1.findLock(FactMan, *LDat2);
 
     if (LDat1) {
       if (LDat1->kind() != LDat2->kind()) {
@@ -2203,12 +2223,12 @@ void ThreadSafetyAnalyzer::intersectAndWarn(FactSet &FSet1,
                                          LDat2->loc(), LDat1->loc());
         if (Modify && LDat1->kind() != LK_Exclusive) {
           // Take the exclusive lock, which is the one in FSet2.
-          *Iter1 = Fact;
+          FSet1.replaceLock(FactMan, *LDat2, Fact);
         }
       }
       else if (Modify && LDat1->asserted() && !LDat2->asserted()) {
         // The non-asserted lock in FSet2 is the one we want to track.
-        *Iter1 = Fact;
+        FSet1.replaceLock(FactMan, *LDat2, Fact);
       }
     } else {
       LDat2->handleRemovalFromIntersection(FSet2, FactMan, JoinLoc, LEK1,
@@ -136,6 +136,7 @@ void DiagnosticsEngine::Reset() {
   // Clear state related to #pragma diagnostic.
   DiagStates.clear();
   DiagStatesByLoc.clear();
+  DerivedDiagStates.clear();
   DiagStateOnPushStack.clear();
 
   // Create a DiagState and DiagStatePoint representing diagnostic changes
@@ -205,6 +206,11 @@ DiagnosticsEngine::DiagStateMap::lookup(SourceManager &SrcMgr,
 
 DiagnosticsEngine::DiagState *
 DiagnosticsEngine::DiagStateMap::File::lookup(unsigned Offset) const {
+  // Most queries are for the point we are currently parsing, which lies after
+  // the last transition.
+  if (Offset >= StateTransitions.back().Offset)
+    return StateTransitions.back().State;
+
   auto OnePastIt = std::upper_bound(
       StateTransitions.begin(), StateTransitions.end(), Offset,
       [](unsigned Offset, const DiagStatePoint &P) {
@@ -217,10 +223,16 @@ DiagnosticsEngine::DiagStateMap::File::lookup(unsigned Offset) const {
 DiagnosticsEngine::DiagStateMap::File *
 DiagnosticsEngine::DiagStateMap::getFile(SourceManager &SrcMgr,
                                          FileID ID) const {
+  if (LastLookupFile && LastLookupFID == ID)
+    return LastLookupFile;
+
   // Get or insert the File for this ID.
   auto Range = Files.equal_range(ID);
-  if (Range.first != Range.second)
-    return &Range.first->second;
+  if (Range.first != Range.second) {
+    LastLookupFID = ID;
+    LastLookupFile = &Range.first->second;
+    return LastLookupFile;
+  }
   auto &F = Files.insert(Range.first, std::make_pair(ID, File()))->second;
 
   // We created a new File; look up the diagnostic state at the start of it and
@@ -240,6 +252,8 @@ DiagnosticsEngine::DiagStateMap::getFile(SourceManager &SrcMgr,
     // end of isBeforeInTranslationUnit for the quirks it deals with.
     F.StateTransitions.push_back({FirstDiagState, 0});
   }
+  LastLookupFID = ID;
+  LastLookupFile = &F;
   return &F;
 }
 
@@ -339,6 +353,36 @@ void DiagnosticsEngine::PushDiagStatePoint(DiagState *State,
   DiagStatesByLoc.append(*SourceMgr, Loc, State);
 }
 
+void DiagnosticsEngine::applyPragmaMapping(diag::Flavor Flavor,
+                                           StringRef Group, diag::Severity Map,
+                                           SourceLocation Loc,
+                                           llvm::function_ref<void()> Apply) {
+  // Command-line mappings, and further mappings at the location of the last
+  // state point, update the current state in place; see setSeverity.
+  if (Loc.isInvalid() || Loc == DiagStatesByLoc.getCurDiagStateLoc() ||
+      !DiagStatesByLoc.getCurDiagState()) {
+    Apply();
+    return;
+  }
+
+  // The result of a pragma depends only on the state it is applied to, so an
+  // identical pragma applied to the same state can share the earlier result.
+  // As with the states shared by push/pop, this relies on a state never being
+  // updated in place once a different location has become current.
+  DiagState *Base = GetCurDiagState();
+  auto Key = std::make_tuple(Base, static_cast<unsigned>(Flavor),
+                             static_cast<unsigned>(Map), Group.str());
+  auto Known = DerivedDiagStates.find(Key);
+  if (Known != DerivedDiagStates.end()) {
+    PushDiagStatePoint(Known->second, Loc);
+    return;
+  }
+
+  Apply();
+  if (GetCurDiagState() != Base)
+    DerivedDiagStates.insert({std::move(Key), GetCurDiagState()});
+}
+
 void DiagnosticsEngine::setSeverity(diag::kind Diag, diag::Severity Map,
                                     SourceLocation L) {
   assert(Diag < diag::DIAG_UPPER_LIMIT &&
@@ -389,8 +433,10 @@ bool DiagnosticsEngine::setSeverityForGroup(diag::Flavor Flavor,
     return true;
 
   // Set the mapping.
-  for (diag::kind Diag : GroupDiags)
-    setSeverity(Diag, Map, Loc);
+  applyPragmaMapping(Flavor, Group, Map, Loc, [&] {
+    for (diag::kind Diag : GroupDiags)
+      setSeverity(Diag, Map, Loc);
+  });
 
   return false;
 }
@@ -464,9 +510,11 @@ void DiagnosticsEngine::setSeverityForAll(diag::Flavor Flavor,
   DiagnosticIDs::getAllDiagnostics(Flavor, AllDiags);
 
   // Set the mapping.
-  for (diag::kind Diag : AllDiags)
-    if (Diags->isBuiltinWarningOrExtension(Diag))
-      setSeverity(Diag, Map, Loc);
+  applyPragmaMapping(Flavor, StringRef(), Map, Loc, [&] {
+    for (diag::kind Diag : AllDiags)
+      if (Diags->isBuiltinWarningOrExtension(Diag))
+        setSeverity(Diag, Map, Loc);
+  });
 }
 
 void DiagnosticsEngine::Report(const StoredDiagnostic &storedDiag) {
@@ -22,19 +22,120 @@
 #include "llvm/Config/llvm-config.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
 #include <climits>
 #include <cstdint>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 
 using namespace clang;
 
+namespace {
+
+/// Releases the shared contents of a file, and forgets them in the pool.
+struct SharedContentsDeleter {
+  llvm::sys::fs::UniqueID ID;
+
+  void operator()(llvm::MemoryBuffer *Buffer) const;
+};
+
+/// The file contents that the file managers in the process currently share,
+/// as of the size and modification time the files had when they were read.
+/// The contents are released, and their entry erased, once no buffer refers
+/// to them anymore.
+class SharedFileBufferPool {
+  struct SharedContents {
+    off_t Size;
+    time_t ModTime;
+    std::weak_ptr<llvm::MemoryBuffer> Buffer;
+  };
+
+  std::mutex Mutex;
+  std::map<llvm::sys::fs::UniqueID, SharedContents> Files;
+
+public:
+  std::shared_ptr<llvm::MemoryBuffer> lookup(const FileEntry &Entry) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto Known = Files.find(Entry.getUniqueID());
+    if (Known == Files.end() || Known->second.Size != Entry.getSize() ||
+        Known->second.ModTime != Entry.getModificationTime())
+      return nullptr;
+    std::shared_ptr<llvm::MemoryBuffer> Shared = Known->second.Buffer.lock();
+    if (!Shared)
+      Files.erase(Known);
+    return Shared;
+  }
+
+  /// Shares \p Buffer as the contents of \p Entry, unless another file
+  /// manager shared them first.
+  std::shared_ptr<llvm::MemoryBuffer>
+  insert(const FileEntry &Entry, std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    SharedContents &Contents = Files[Entry.getUniqueID()];
+    if (Contents.Size == Entry.getSize() &&
+        Contents.ModTime == Entry.getModificationTime())
+      if (std::shared_ptr<llvm::MemoryBuffer> Shared = Contents.Buffer.lock())
+        return Shared;
+    std::shared_ptr<llvm::MemoryBuffer> Shared(
+        Buffer.release(), SharedContentsDeleter{Entry.getUniqueID()});
+    Contents = {Entry.getSize(), Entry.getModificationTime(), Shared};
+    return Shared;
+  }
+
+  /// Erases the entry of the file with \p ID, unless other contents of the
+  /// file were shared since its last buffer went away.
+  void release(llvm::sys::fs::UniqueID ID) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto Known = Files.find(ID);
+    if (Known != Files.end() && Known->second.Buffer.expired())
+      Files.erase(Known);
+  }
+
+  unsigned size() {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Files.size();
+  }
+};
+
+/// A buffer that refers to shared file contents.
+class SharedFileBuffer : public llvm::MemoryBuffer {
+  std::shared_ptr<llvm::MemoryBuffer> Contents;
+  std::string Name;
+
+public:
+  SharedFileBuffer(std::shared_ptr<llvm::MemoryBuffer> Contents,
+                   StringRef Name)
+      : Contents(std::move(Contents)), Name(Name) {
+    init(this->Contents->getBufferStart(), this->Contents->getBufferEnd(),
+         /*RequiresNullTerminator=*/true);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+
+  BufferKind getBufferKind() const override {
+    return Contents->getBufferKind();
+  }
+};
+
+} // end anonymous namespace
+
+static llvm::ManagedStatic<SharedFileBufferPool> SharedFileBuffers;
+
+void SharedContentsDeleter::operator()(llvm::MemoryBuffer *Buffer) const {
+  delete Buffer;
+  SharedFileBuffers->release(ID);
+}
+
 //===----------------------------------------------------------------------===//
 // Common logic.
 //===----------------------------------------------------------------------===//
@@ -431,6 +532,35 @@ void FileManager::fillRealPathName(FileEntry *UFE, llvm::StringRef FileName) {
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
 FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
                               bool ShouldCloseOpenFile) {
+  // Volatile files may change while they are in use, so their contents are
+  // never shared.
+  if (!FileSystemOpts.ShareFileBuffers || isVolatile)
+    return readBufferForFile(Entry, isVolatile, ShouldCloseOpenFile);
+
+  std::shared_ptr<llvm::MemoryBuffer> Shared =
+      SharedFileBuffers->lookup(*Entry);
+  if (Shared) {
+    if (ShouldCloseOpenFile)
+      Entry->closeFile();
+  } else {
+    auto Result = readBufferForFile(Entry, isVolatile, ShouldCloseOpenFile);
+    // If the file changed since its entry was created, the contents do not
+    // belong to the entry's size and modification time.
+    if (!Result || (*Result)->getBufferSize() != (uint64_t)Entry->getSize())
+      return Result;
+    Shared = SharedFileBuffers->insert(*Entry, std::move(*Result));
+  }
+  return std::unique_ptr<llvm::MemoryBuffer>(
+      new SharedFileBuffer(std::move(Shared), Entry->getName()));
+}
+
+unsigned FileManager::getNumSharedFileBuffers() {
+  return SharedFileBuffers->size();
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+FileManager::readBufferForFile(const FileEntry *Entry, bool isVolatile,
+                               bool ShouldCloseOpenFile) {
   uint64_t FileSize = Entry->getSize();
   // If there's a high enough chance that the file have changed since we
   // got its size, force a stat before opening it.
@@ -472,6 +602,45 @@ FileManager::getBufferForFile(StringRef Filename, bool isVolatile) {
   return FS->getBufferForFile(FilePath.c_str(), -1, true, isVolatile);
 }
 
+void FileManager::prefetchFileStats(ArrayRef<std::string> Paths) {
+  // Only the creator of the file system knows whether it can be used from
+  // several threads. A stat cache has to see every stat, and a few files are
+  // not worth starting threads for.
+  const unsigned MinStatsToPrefetch = 32;
+  if (!FileSystemOpts.PrefetchFileStats || StatCache ||
+      Paths.size() < MinStatsToPrefetch)
+    return;
+
+  std::vector<std::string> ToStat;
+  for (const std::string &Path : Paths)
+    if (!SeenFileEntries.count(Path) && !PrefetchedStats.count(Path))
+      ToStat.push_back(Path);
+  if (ToStat.size() < MinStatsToPrefetch)
+    return;
+
+  std::vector<llvm::ErrorOr<llvm::vfs::Status>> Results(
+      ToStat.size(), std::make_error_code(std::errc::no_such_file_or_directory));
+  {
+    llvm::ThreadPool Pool(std::min(llvm::hardware_concurrency(), 8u));
+    for (unsigned I = 0, E = ToStat.size(); I != E; ++I) {
+      SmallString<128> FilePath(ToStat[I]);
+      FixupRelativePath(FilePath);
+      Pool.async([this, &Results, I, FilePath] {
+        Results[I] = FS->status(FilePath);
+      });
+    }
+    Pool.wait();
+  }
+
+  // Failed stats are repeated by the lookup, which reports their error.
+  for (unsigned I = 0, E = ToStat.size(); I != E; ++I) {
+    if (!Results[I] || Results[I]->isDirectory())
+      continue;
+    PrefetchedStats[ToStat[I]] = std::move(*Results[I]);
+    ++NumStatsPrefetched;
+  }
+}
+
 /// getStatValue - Get the 'stat' information for the specified path,
 /// using the cache to accelerate it if possible.  This returns true
 /// if the path points to a virtual file or does not exist, or returns
@@ -480,6 +649,17 @@ FileManager::getBufferForFile(StringRef Filename, bool isVolatile) {
 std::error_code
 FileManager::getStatValue(StringRef Path, llvm::vfs::Status &Status,
                           bool isFile, std::unique_ptr<llvm::vfs::File> *F) {
+  // Use a prefetched stat once; lookups that open the file need to stat it
+  // through the open file anyway.
+  if (isFile && !F && !PrefetchedStats.empty()) {
+    auto Prefetched = PrefetchedStats.find(Path);
+    if (Prefetched != PrefetchedStats.end()) {
+      Status = std::move(Prefetched->second);
+      PrefetchedStats.erase(Prefetched);
+      return std::error_code();
+    }
+  }
+
   // FIXME: FileSystemOpts shouldn't be passed in here, all paths should be
   // absolute!
   if (FileSystemOpts.WorkingDir.empty())
@@ -574,6 +754,9 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  llvm::errs() << NumStatsPrefetched << " stats prefetched.\n";
+  llvm::errs() << getNumSharedFileBuffers()
+               << " file buffers shared in the process.\n";
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
@@ -2020,6 +2020,18 @@ void SourceManager::PrintStats() const {
                << llvm::capacity_in_bytes(LocalSLocEntryTable)
                << " bytes of capacity), "
                << NextLocalOffset << "B of Sloc address space used.\n";
+  unsigned NumMacroArgExpansions = 0, NumOtherExpansions = 0;
+  for (const SrcMgr::SLocEntry &Entry : LocalSLocEntryTable) {
+    if (!Entry.isExpansion())
+      continue;
+    if (Entry.getExpansion().isMacroArgExpansion())
+      ++NumMacroArgExpansions;
+    else
+      ++NumOtherExpansions;
+  }
+  llvm::errs() << "  " << NumMacroArgExpansions
+               << " macro argument expansions, " << NumOtherExpansions
+               << " other expansions.\n";
   llvm::errs() << LoadedSLocEntryTable.size()
                << " loaded SLocEntries allocated, "
                << MaxLoadedOffset - CurrentLoadedOffset
@@ -882,21 +882,26 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    llvm::TimeTraceScope TimeScope("PerFunctionPasses", StringRef(""));
 
     PerFunctionPasses.doInitialization();
     for (Function &F : *TheModule)
-      if (!F.isDeclaration())
+      if (!F.isDeclaration()) {
+        llvm::TimeTraceScope FunctionScope("OptFunction", F.getName());
         PerFunctionPasses.run(F);
+      }
     PerFunctionPasses.doFinalization();
   }
 
   {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    llvm::TimeTraceScope TimeScope("PerModulePasses", StringRef(""));
     PerModulePasses.run(*TheModule);
   }
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
+    llvm::TimeTraceScope TimeScope("CodeGenPasses", StringRef(""));
     CodeGenPasses.run(*TheModule);
   }
 
@@ -982,6 +987,18 @@ static void addSanitizersAtO0(ModulePassManager &MPM,
   }
 }
 
+/// Records a time trace event for every pass the new pass manager runs.
+static void addTimeTraceCallbacks(PassInstrumentationCallbacks &PIC) {
+  PIC.registerBeforePassCallback([](StringRef Pass, Any) {
+    llvm::timeTraceProfilerBegin("RunPass", Pass);
+    return true;
+  });
+  PIC.registerAfterPassCallback(
+      [](StringRef, Any) { llvm::timeTraceProfilerEnd(); });
+  PIC.registerAfterPassInvalidatedCallback(
+      [](StringRef) { llvm::timeTraceProfilerEnd(); });
+}
+
 /// A clean version of `EmitAssembly` that uses the new pass manager.
 ///
 /// Not all features are currently supported in this system, but where
@@ -1063,7 +1080,10 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   PTO.LoopVectorization = CodeGenOpts.VectorizeLoop;
   PTO.SLPVectorization = CodeGenOpts.VectorizeSLP;
 
-  PassBuilder PB(TM.get(), PTO, PGOOpt);
+  PassInstrumentationCallbacks PIC;
+  if (llvm::timeTraceProfilerEnabled())
+    addTimeTraceCallbacks(PIC);
+  PassBuilder PB(TM.get(), PTO, PGOOpt, &PIC);
 
   // Attempt to load pass plugins and register their callbacks with PB.
   for (auto &PluginFN : CodeGenOpts.PassPlugins) {
@@ -1298,12 +1318,14 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // Now that we have all of the passes ready, run them.
   {
     PrettyStackTraceString CrashInfo("Optimizer");
+    llvm::TimeTraceScope TimeScope("Optimizer", StringRef(""));
     MPM.run(*TheModule, MAM);
   }
 
   // Now if needed, run the legacy PM for codegen.
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
+    llvm::TimeTraceScope TimeScope("CodeGenPasses", StringRef(""));
     CodeGenPasses.run(*TheModule);
   }
 
@@ -1412,6 +1412,9 @@ static void ParseDependencyOutputArgs(DependencyOutputOptions &Opts,
     Opts.ShowIncludesDest = ShowIncludesDestination::None;
   }
   Opts.DOTOutputFile = Args.getLastArgValue(OPT_dependency_dot);
+  Opts.HeaderCostOutputFile = Args.getLastArgValue(OPT_header_cost_report);
+  Opts.UnusedIncludesOutputFile =
+      Args.getLastArgValue(OPT_unused_include_report);
   Opts.ModuleDependencyOutputDir =
       Args.getLastArgValue(OPT_module_dependency_dir);
   if (Args.hasArg(OPT_MV))
@@ -1816,6 +1819,7 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.ModulesEmbedFiles = Args.getAllArgValues(OPT_fmodules_embed_file_EQ);
   Opts.ModulesEmbedAllFiles = Args.hasArg(OPT_fmodules_embed_all_files);
   Opts.IncludeTimestamps = !Args.hasArg(OPT_fno_pch_timestamp);
+  Opts.MinimizeHeaders = Args.hasArg(OPT_minimize_headers);
 
   Opts.CodeCompleteOpts.IncludeMacros
     = Args.hasArg(OPT_code_completion_macros);
@@ -3543,6 +3547,12 @@ std::string CompilerInvocation::getModuleHash(DiagnosticsEngine &Diags) const {
     code = hash_combine(code, ext->hashExtension(code));
   }
 
+  // Modules built from headers with their comments blanked out must not be
+  // used by compilations that read the headers as they are. The blanked out
+  // headers have the size and modification time of the originals, so input
+  // file validation cannot tell them apart.
+  code = hash_combine(code, frontendOpts.MinimizeHeaders);
+
   // Extend the signature with the SWift version for API notes.
   const APINotesOptions &apiNotesOpts = getAPINotesOpts();
   if (apiNotesOpts.SwiftVersion) {
@@ -3628,6 +3638,17 @@ createVFSFromCompilerInvocation(const CompilerInvocation &CI,
 IntrusiveRefCntPtr<llvm::vfs::FileSystem> createVFSFromCompilerInvocation(
     const CompilerInvocation &CI, DiagnosticsEngine &Diags,
     IntrusiveRefCntPtr<llvm::vfs::FileSystem> BaseFS) {
+  const FrontendOptions &FEOpts = CI.getFrontendOpts();
+  if (FEOpts.MinimizeHeaders) {
+    std::vector<std::string> MainFiles;
+    for (const FrontendInputFile &Input : FEOpts.Inputs)
+      if (Input.isFile())
+        MainFiles.push_back(Input.getFile());
+    BaseFS = createMinimizedHeaderFileSystem(std::move(BaseFS), MainFiles,
+                                             CI.getLangOpts()->LineComment,
+                                             CI.getLangOpts()->CPlusPlus11);
+  }
+
   if (CI.getHeaderSearchOpts().VFSOverlayFiles.empty())
     return BaseFS;
 
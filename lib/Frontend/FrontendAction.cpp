@@ -152,6 +152,27 @@ FrontendAction::CreateWrappedASTConsumer(CompilerInstance &CI,
   if (!Consumer)
     return nullptr;
 
+  // Measure the headers, and find the unused ones, while the main consumer is
+  // fed.
+  if (CI.hasPreprocessor() && !CI.hasCodeCompletionConsumer()) {
+    const DependencyOutputOptions &DepOpts = CI.getDependencyOutputOpts();
+    std::vector<std::unique_ptr<ASTConsumer>> Consumers;
+    if (!DepOpts.HeaderCostOutputFile.empty())
+      Consumers.push_back(CreateHeaderCostReporter(
+          CI.getPreprocessor(), DepOpts.HeaderCostOutputFile));
+    // The includes of a precompiled header or a module are its contents.
+    if ((!DepOpts.UnusedIncludesOutputFile.empty() ||
+         !CI.getDiagnostics().isIgnored(diag::warn_fe_unused_include,
+                                        SourceLocation())) &&
+        !CI.getLangOpts().CompilingPCH && !CI.getLangOpts().isCompilingModule())
+      Consumers.push_back(CreateUnusedIncludeReporter(
+          CI.getPreprocessor(), DepOpts.UnusedIncludesOutputFile));
+    if (!Consumers.empty()) {
+      Consumers.insert(Consumers.begin(), std::move(Consumer));
+      Consumer = llvm::make_unique<MultiplexConsumer>(std::move(Consumers));
+    }
+  }
+
   // Validate -add-plugin args.
   bool FoundAllPlugins = true;
   for (const std::string &Arg : CI.getFrontendOpts().AddPluginActions) {
@@ -0,0 +1,225 @@
+//===--- HeaderCostReport.cpp - Report the cost of included headers -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This code measures the time spent in every header that a translation unit
+// includes, counts the declarations each header introduces and writes both
+// as JSON, so that the reports of a whole build can be merged to find the
+// headers that are worth removing or precompiling.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/DeclGroup.h"
+#include "clang/AST/DeclObjC.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+using namespace clang;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// The cost of one header, summed over all the times it was entered.
+struct HeaderCost {
+  const FileEntry *File;
+
+  /// The number of times the header was entered, and the number of times it
+  /// was skipped because of its include guard or '#pragma once'.
+  unsigned Entered = 0;
+  unsigned Skipped = 0;
+
+  /// The time from entering the header until leaving it, and that time minus
+  /// the time spent in the headers it includes. Lexing, parsing and Sema are
+  /// interleaved, so they are not told apart.
+  Clock::duration Time = Clock::duration::zero();
+  Clock::duration SelfTime = Clock::duration::zero();
+
+  /// The declarations written in the header itself, and those written in it
+  /// or in the headers it includes.
+  unsigned Decls = 0;
+  unsigned InclusiveDecls = 0;
+
+  explicit HeaderCost(const FileEntry *File) : File(File) {}
+};
+
+class HeaderCostCollector : public PPCallbacks {
+  /// A header that is being lexed.
+  struct OpenHeader {
+    FileID FID;
+    unsigned Header;
+    Clock::time_point Start;
+    Clock::duration NestedTime;
+  };
+
+  /// Where a file that was entered came from.
+  struct EnteredFile {
+    unsigned Header;
+    FileID IncludedFrom;
+  };
+
+  const SourceManager &SM;
+  std::vector<HeaderCost> Headers;
+  llvm::DenseMap<const FileEntry *, unsigned> HeaderIndex;
+  llvm::DenseMap<FileID, EnteredFile> EnteredFiles;
+  SmallVector<OpenHeader, 16> Stack;
+
+  unsigned getHeader(const FileEntry *File) {
+    auto Inserted = HeaderIndex.try_emplace(File, Headers.size());
+    if (Inserted.second)
+      Headers.emplace_back(File);
+    return Inserted.first->second;
+  }
+
+public:
+  explicit HeaderCostCollector(const SourceManager &SM) : SM(SM) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override;
+
+  void FileSkipped(const FileEntryRef &SkippedFile, const Token &FilenameTok,
+                   SrcMgr::CharacteristicKind FileType) override {
+    ++Headers[getHeader(&SkippedFile.getFileEntry())].Skipped;
+  }
+
+  /// Attributes \p D and the members it was parsed with to the header it is
+  /// written in, and to the headers that include that one.
+  void countDecl(const Decl *D);
+
+  llvm::json::Value toJSON() const;
+};
+
+class HeaderCostReporter : public ASTConsumer {
+  Preprocessor &PP;
+  std::string OutputFile;
+
+  /// Owned by the preprocessor, which outlives parsing.
+  HeaderCostCollector *Collector;
+
+public:
+  HeaderCostReporter(Preprocessor &PP, StringRef OutputFile)
+      : PP(PP), OutputFile(OutputFile) {
+    auto Callbacks = llvm::make_unique<HeaderCostCollector>(
+        PP.getSourceManager());
+    Collector = Callbacks.get();
+    PP.addPPCallbacks(std::move(Callbacks));
+  }
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    for (const Decl *D : DG)
+      Collector->countDecl(D);
+    return true;
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override;
+};
+
+} // end anonymous namespace
+
+void HeaderCostCollector::FileChanged(SourceLocation Loc,
+                                      FileChangeReason Reason,
+                                      SrcMgr::CharacteristicKind FileType,
+                                      FileID PrevFID) {
+  if (Reason == ExitFile) {
+    if (Stack.empty() || Stack.back().FID != PrevFID)
+      return;
+    OpenHeader Closed = Stack.pop_back_val();
+    Clock::duration Time = Clock::now() - Closed.Start;
+    HeaderCost &Cost = Headers[Closed.Header];
+    Cost.Time += Time;
+    Cost.SelfTime += Time - Closed.NestedTime;
+    if (!Stack.empty())
+      Stack.back().NestedTime += Time;
+    return;
+  }
+
+  if (Reason != EnterFile)
+    return;
+  FileID FID = SM.getFileID(Loc);
+  const FileEntry *File = SM.getFileEntryForID(FID);
+  if (!File || FID == SM.getMainFileID())
+    return;
+
+  unsigned Header = getHeader(File);
+  ++Headers[Header].Entered;
+  EnteredFiles[FID] = {Header, Stack.empty() ? FileID() : Stack.back().FID};
+  Stack.push_back({FID, Header, Clock::now(), Clock::duration::zero()});
+}
+
+void HeaderCostCollector::countDecl(const Decl *D) {
+  if (D->isImplicit())
+    return;
+
+  SourceLocation Loc = D->getLocation();
+  if (Loc.isValid()) {
+    FileID FID = SM.getFileID(SM.getExpansionLoc(Loc));
+    auto Entered = EnteredFiles.find(FID);
+    if (Entered != EnteredFiles.end())
+      ++Headers[Entered->second.Header].Decls;
+    for (; Entered != EnteredFiles.end();
+         Entered = EnteredFiles.find(Entered->second.IncludedFrom))
+      ++Headers[Entered->second.Header].InclusiveDecls;
+  }
+
+  // Namespaces, linkage specifications and classes reach the consumer as a
+  // single declaration, together with their members.
+  if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D) || isa<ExportDecl>(D) ||
+      isa<TagDecl>(D) || isa<ObjCContainerDecl>(D))
+    for (const Decl *Member : cast<DeclContext>(D)->noload_decls())
+      countDecl(Member);
+}
+
+llvm::json::Value HeaderCostCollector::toJSON() const {
+  auto Microseconds = [](Clock::duration Time) {
+    return static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Time).count());
+  };
+
+  llvm::json::Array Report;
+  for (const HeaderCost &Cost : Headers)
+    Report.push_back(llvm::json::Object{
+        {"file", Cost.File->getName()},
+        {"entered", Cost.Entered},
+        {"skipped", Cost.Skipped},
+        {"time-us", Microseconds(Cost.Time)},
+        {"self-time-us", Microseconds(Cost.SelfTime)},
+        {"decls", Cost.Decls},
+        {"inclusive-decls", Cost.InclusiveDecls}});
+
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  return llvm::json::Object{
+      {"main-file", MainFile ? MainFile->getName() : StringRef("<unknown>")},
+      {"headers", std::move(Report)}};
+}
+
+void HeaderCostReporter::HandleTranslationUnit(ASTContext &Ctx) {
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    PP.getDiagnostics().Report(diag::err_fe_error_opening) << OutputFile
+                                                            << EC.message();
+    return;
+  }
+  OS << llvm::formatv("{0:2}\n", Collector->toJSON());
+}
+
+std::unique_ptr<ASTConsumer>
+clang::CreateHeaderCostReporter(Preprocessor &PP, StringRef OutputFile) {
+  return llvm::make_unique<HeaderCostReporter>(PP, OutputFile);
+}
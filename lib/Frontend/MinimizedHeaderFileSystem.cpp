@@ -0,0 +1,199 @@
+//===--- MinimizedHeaderFileSystem.cpp - Read headers without comments ----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// A file system that hands out headers with their comments and "#if 0" blocks
+// blanked out, which makes lexing them in a full compilation cheaper.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include <mutex>
+
+using namespace clang;
+
+#define DEBUG_TYPE "minimized-headers"
+
+STATISTIC(NumHeadersMinimized, "Number of headers blanked out");
+STATISTIC(NumMinimizedCacheHits,
+          "Number of headers whose blanked out form was reused");
+
+namespace {
+
+/// A blanked out header, as of the size and modification time the file had
+/// when it was read.
+struct MinimizedHeader {
+  uint64_t Size;
+  llvm::sys::TimePoint<> ModificationTime;
+
+  /// The blanked out contents, or null if the header is read unchanged.
+  std::shared_ptr<llvm::MemoryBuffer> Buffer;
+};
+
+/// The blanked out headers of all the compilations in the process.
+class MinimizedHeaderCache {
+  std::mutex Mutex;
+  llvm::StringMap<MinimizedHeader> Headers;
+
+public:
+  bool lookup(StringRef Key, const llvm::vfs::Status &Status,
+              std::shared_ptr<llvm::MemoryBuffer> &Buffer) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto Known = Headers.find(Key);
+    if (Known == Headers.end() ||
+        Known->second.Size != Status.getSize() ||
+        Known->second.ModificationTime != Status.getLastModificationTime())
+      return false;
+    Buffer = Known->second.Buffer;
+    return true;
+  }
+
+  void insert(StringRef Key, const llvm::vfs::Status &Status,
+              std::shared_ptr<llvm::MemoryBuffer> Buffer) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Headers[Key] = {Status.getSize(), Status.getLastModificationTime(),
+                    std::move(Buffer)};
+  }
+};
+
+/// A buffer that shares the contents of a cached blanked out header, so that
+/// the contents stay alive even if the cache entry is replaced.
+class SharedHeaderBuffer : public llvm::MemoryBuffer {
+  std::shared_ptr<llvm::MemoryBuffer> Contents;
+  std::string Name;
+
+public:
+  SharedHeaderBuffer(std::shared_ptr<llvm::MemoryBuffer> Contents,
+                     StringRef Name)
+      : Contents(std::move(Contents)), Name(Name) {
+    init(this->Contents->getBufferStart(), this->Contents->getBufferEnd(),
+         /*RequiresNullTerminator=*/true);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+
+  BufferKind getBufferKind() const override { return MemoryBuffer_Malloc; }
+};
+
+/// A file whose contents are a blanked out header.
+class MinimizedHeaderFile : public llvm::vfs::File {
+  std::shared_ptr<llvm::MemoryBuffer> Contents;
+  llvm::vfs::Status Stat;
+
+public:
+  MinimizedHeaderFile(std::shared_ptr<llvm::MemoryBuffer> Contents,
+                      llvm::vfs::Status Stat)
+      : Contents(std::move(Contents)), Stat(std::move(Stat)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status() override { return Stat; }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::unique_ptr<llvm::MemoryBuffer>(
+        new SharedHeaderBuffer(Contents, Name.str()));
+  }
+
+  std::error_code close() override { return {}; }
+};
+
+class MinimizedHeaderFileSystem : public llvm::vfs::ProxyFileSystem {
+  llvm::StringSet<> MainFiles;
+  bool LineComments;
+  bool RawStringLiterals;
+
+public:
+  MinimizedHeaderFileSystem(IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+                            ArrayRef<std::string> MainFiles, bool LineComments,
+                            bool RawStringLiterals)
+      : ProxyFileSystem(std::move(FS)), LineComments(LineComments),
+        RawStringLiterals(RawStringLiterals) {
+    for (const std::string &File : MainFiles)
+      this->MainFiles.insert(File);
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+  openFileForRead(const Twine &Path) override;
+};
+
+} // end anonymous namespace
+
+static llvm::ManagedStatic<MinimizedHeaderCache> HeaderCache;
+
+/// Returns true if \p Path names a file that is included as a header. The
+/// standard C++ headers have no extension.
+static bool isHeaderPath(StringRef Path) {
+  return llvm::StringSwitch<bool>(llvm::sys::path::extension(Path))
+      .Cases("", ".h", ".hh", ".hpp", ".hxx", ".h++", ".H", true)
+      .Cases(".inc", ".def", ".inl", ".ipp", ".tcc", true)
+      .Default(false);
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+MinimizedHeaderFileSystem::openFileForRead(const Twine &Path) {
+  SmallString<256> OwnedPath;
+  StringRef Filename = Path.toStringRef(OwnedPath);
+
+  auto File = getUnderlyingFS().openFileForRead(Path);
+  if (!File || !isHeaderPath(Filename) || MainFiles.count(Filename))
+    return File;
+
+  llvm::ErrorOr<llvm::vfs::Status> Status = (*File)->status();
+  if (!Status)
+    return File;
+
+  SmallString<256> Key(Filename);
+  Key += LineComments ? ":1" : ":0";
+  Key += RawStringLiterals ? ":1" : ":0";
+  std::shared_ptr<llvm::MemoryBuffer> Minimized;
+  if (HeaderCache->lookup(Key, *Status, Minimized)) {
+    ++NumMinimizedCacheHits;
+  } else {
+    auto Buffer = (*File)->getBuffer(Filename, Status->getSize());
+    if (!Buffer)
+      return Buffer.getError();
+
+    // Leave files that are not text, or that the minimizer cannot handle,
+    // alone.
+    StringRef Contents = (*Buffer)->getBuffer();
+    SmallString<0> Output;
+    if (Contents.find('\0') == StringRef::npos &&
+        !blankOutCommentsAndDisabledBlocks(Contents, Output, LineComments,
+                                           RawStringLiterals)) {
+      Minimized = llvm::MemoryBuffer::getMemBufferCopy(Output, Filename);
+      ++NumHeadersMinimized;
+    }
+    HeaderCache->insert(Key, *Status, Minimized);
+
+    // The file has been read already, so hand out what was read.
+    if (!Minimized)
+      Minimized = std::move(*Buffer);
+  }
+
+  if (!Minimized)
+    return File;
+  return std::unique_ptr<llvm::vfs::File>(
+      new MinimizedHeaderFile(std::move(Minimized), std::move(*Status)));
+}
+
+IntrusiveRefCntPtr<llvm::vfs::FileSystem>
+clang::createMinimizedHeaderFileSystem(
+    IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS,
+    ArrayRef<std::string> MainFiles, bool LineComments,
+    bool RawStringLiterals) {
+  return new MinimizedHeaderFileSystem(std::move(FS), MainFiles, LineComments,
+                                       RawStringLiterals);
+}
@@ -23,12 +23,19 @@
 #include "clang/Lex/TokenConcatenation.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
 using namespace clang;
 
+#define DEBUG_TYPE "print-preprocessed-output"
+
+STATISTIC(NumTokensPrinted, "Number of tokens printed");
+STATISTIC(NumPunctuatorsPrinted,
+          "Number of punctuators printed without looking up their spelling");
+
 /// PrintMacroDefinition - Print a macro definition in a form that will be
 /// properly accepted back as a definition.
 static void PrintMacroDefinition(const IdentifierInfo &II, const MacroInfo &MI,
@@ -708,6 +715,20 @@ struct UnknownPragmaHandler : public PragmaHandler {
 };
 } // end anonymous namespace
 
+/// Returns the spelling of the punctuator \p Tok if it is known without
+/// looking at the source, or null otherwise.
+///
+/// A punctuator spelled as a digraph, or with an escaped newline or trigraph
+/// in it, has to be printed the way it is written, and has a different length
+/// than the canonical spelling.
+static const char *getPunctuatorSpellingIfExact(const Token &Tok) {
+  if (Tok.needsCleaning())
+    return nullptr;
+  const char *Spelling = tok::getPunctuatorSpelling(Tok.getKind());
+  if (!Spelling || strlen(Spelling) != Tok.getLength())
+    return nullptr;
+  return Spelling;
+}
 
 static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
                                     PrintPPOutputPPCallbacks *Callbacks,
@@ -789,6 +810,11 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
     } else if (Tok.isLiteral() && !Tok.needsCleaning() &&
                Tok.getLiteralData()) {
       OS.write(Tok.getLiteralData(), Tok.getLength());
+    } else if (const char *Punc = getPunctuatorSpellingIfExact(Tok)) {
+      // Most of the remaining tokens are punctuators, whose spelling does not
+      // have to be looked up in the source buffer.
+      OS.write(Punc, Tok.getLength());
+      ++NumPunctuatorsPrinted;
     } else if (Tok.getLength() < llvm::array_lengthof(Buffer)) {
       const char *TokPtr = Buffer;
       unsigned Len = PP.getSpelling(Tok, TokPtr);
@@ -808,6 +834,7 @@ static void PrintPreprocessedTokens(Preprocessor &PP, Token &Tok,
         Callbacks->HandleNewlinesInToken(S.data(), S.size());
     }
     Callbacks->setEmittedTokensOnThisLine();
+    ++NumTokensPrinted;
 
     if (Tok.is(tok::eof)) break;
 
@@ -864,6 +891,14 @@ void clang::DoPrintPreprocessedInput(Preprocessor &PP, raw_ostream *OS,
     return;
   }
 
+  // The output is written a few characters at a time, so make sure it is
+  // collected into large writes. Unbuffered streams, such as the terminal,
+  // stay unbuffered.
+  const size_t MinOutputBufferSize = 64 * 1024;
+  size_t BufferSize = OS->GetBufferSize();
+  if (BufferSize != 0 && BufferSize < MinOutputBufferSize)
+    OS->SetBufferSize(MinOutputBufferSize);
+
   // Inform the preprocessor whether we want it to retain comments or not, due
   // to -C or -CC.
   PP.SetCommentRetentionState(Opts.ShowComments, Opts.ShowMacroComments);
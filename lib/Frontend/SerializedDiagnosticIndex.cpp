@@ -0,0 +1,252 @@
+//===- SerializedDiagnosticIndex.cpp - Merged serialized diagnostics ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/SerializedDiagnosticIndex.h"
+#include "clang/Frontend/SerializedDiagnosticPrinter.h"
+#include "clang/Frontend/SerializedDiagnosticReader.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace clang::serialized_diags;
+
+namespace {
+
+/// Reads serialized diagnostics into \c LoadedDiagnostic trees.
+class DiagnosticLoader : public SerializedDiagnosticReader {
+  std::vector<LoadedDiagnostic> &Result;
+
+  llvm::DenseMap<unsigned, std::string> Files;
+  llvm::DenseMap<unsigned, std::string> Categories;
+  llvm::DenseMap<unsigned, std::string> Flags;
+
+  /// The diagnostics whose blocks we are in, innermost last. Only the
+  /// innermost diagnostic gains children, so these pointers stay valid.
+  SmallVector<LoadedDiagnostic *, 4> Stack;
+
+public:
+  DiagnosticLoader(std::vector<LoadedDiagnostic> &Result) : Result(Result) {}
+
+protected:
+  std::error_code visitStartOfDiagnostic() override {
+    if (Stack.empty()) {
+      Result.emplace_back();
+      Stack.push_back(&Result.back());
+    } else {
+      Stack.back()->Children.emplace_back();
+      Stack.push_back(&Stack.back()->Children.back());
+    }
+    return {};
+  }
+
+  std::error_code visitEndOfDiagnostic() override {
+    Stack.pop_back();
+    return {};
+  }
+
+  std::error_code visitCategoryRecord(unsigned ID, StringRef Name) override {
+    Categories[ID] = Name;
+    return {};
+  }
+
+  std::error_code visitDiagFlagRecord(unsigned ID, StringRef Name) override {
+    Flags[ID] = Name;
+    return {};
+  }
+
+  std::error_code visitFilenameRecord(unsigned ID, unsigned Size,
+                                      unsigned Timestamp,
+                                      StringRef Name) override {
+    Files[ID] = Name;
+    return {};
+  }
+
+  std::error_code visitDiagnosticRecord(unsigned Severity,
+                                        const Location &Location,
+                                        unsigned Category, unsigned Flag,
+                                        StringRef Message) override {
+    LoadedDiagnostic &D = *Stack.back();
+    D.Severity = Severity;
+    D.Loc = resolve(Location);
+    D.Category = Category;
+    D.CategoryName = Categories.lookup(Category);
+    D.Flag = Flags.lookup(Flag);
+    D.Message = Message;
+    return {};
+  }
+
+  std::error_code visitSourceRangeRecord(const Location &Start,
+                                         const Location &End) override {
+    Stack.back()->Ranges.emplace_back(resolve(Start), resolve(End));
+    return {};
+  }
+
+  std::error_code visitFixitRecord(const Location &Start, const Location &End,
+                                   StringRef Text) override {
+    Stack.back()->FixIts.push_back({resolve(Start), resolve(End), Text});
+    return {};
+  }
+
+private:
+  LoadedLocation resolve(const Location &Loc) {
+    LoadedLocation Result;
+    Result.Filename = Files.lookup(Loc.FileID);
+    Result.Line = Loc.Line;
+    Result.Col = Loc.Col;
+    Result.Offset = Loc.Offset;
+    return Result;
+  }
+};
+
+} // namespace
+
+static void writeKey(const LoadedLocation &Loc, llvm::raw_ostream &OS) {
+  OS << Loc.Filename.size() << ':' << Loc.Filename << ':' << Loc.Line << ':'
+     << Loc.Col << ':' << Loc.Offset << ';';
+}
+
+static void writeKey(StringRef Str, llvm::raw_ostream &OS) {
+  OS << Str.size() << ':' << Str << ';';
+}
+
+/// Write a string that is equal for two diagnostics exactly when they are
+/// identical.
+static void writeKey(const LoadedDiagnostic &D, llvm::raw_ostream &OS) {
+  OS << D.Severity << ';';
+  writeKey(D.Loc, OS);
+  OS << D.Category << ';';
+  writeKey(D.Flag, OS);
+  writeKey(D.Message, OS);
+  OS << D.Ranges.size() << ';';
+  for (const auto &Range : D.Ranges) {
+    writeKey(Range.first, OS);
+    writeKey(Range.second, OS);
+  }
+  OS << D.FixIts.size() << ';';
+  for (const LoadedDiagnostic::FixIt &Fix : D.FixIts) {
+    writeKey(Fix.Start, OS);
+    writeKey(Fix.End, OS);
+    writeKey(Fix.Text, OS);
+  }
+  OS << D.Children.size() << ';';
+  for (const LoadedDiagnostic &Child : D.Children)
+    writeKey(Child, OS);
+}
+
+llvm::ErrorOr<std::vector<LoadedDiagnostic>>
+clang::serialized_diags::loadDiagnostics(StringRef File) {
+  std::vector<LoadedDiagnostic> Result;
+  if (std::error_code EC = DiagnosticLoader(Result).readDiagnostics(File))
+    return EC;
+  return std::move(Result);
+}
+
+llvm::ErrorOr<std::vector<LoadedDiagnostic>>
+clang::serialized_diags::loadDiagnosticsForFile(StringRef File,
+                                                StringRef SourceFile) {
+  std::vector<LoadedDiagnostic> Result;
+  std::error_code EC =
+      DiagnosticLoader(Result).readDiagnosticsForFile(File, SourceFile);
+  if (EC != SDError::MissingIndex) {
+    if (EC)
+      return EC;
+    return std::move(Result);
+  }
+
+  // Without an index, read everything and keep the diagnostics we want.
+  llvm::ErrorOr<std::vector<LoadedDiagnostic>> All = loadDiagnostics(File);
+  if (!All)
+    return All.getError();
+  Result.clear();
+  for (LoadedDiagnostic &D : *All)
+    if (D.Loc.Filename == SourceFile)
+      Result.push_back(std::move(D));
+  return std::move(Result);
+}
+
+llvm::Expected<MergedDiagnostics>
+MergedDiagnostics::create(ArrayRef<std::string> Files, unsigned NumThreads) {
+  // Load every file, and compute the deduplication keys, in parallel.
+  std::vector<std::vector<LoadedDiagnostic>> Loaded(Files.size());
+  std::vector<std::vector<std::string>> Keys(Files.size());
+  std::vector<std::error_code> Errors(Files.size());
+  {
+    llvm::ThreadPool Pool(NumThreads == 0 ? llvm::hardware_concurrency()
+                                          : NumThreads);
+    for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+      Pool.async([&, I] {
+        llvm::ErrorOr<std::vector<LoadedDiagnostic>> Diags =
+            loadDiagnostics(Files[I]);
+        if (!Diags) {
+          Errors[I] = Diags.getError();
+          return;
+        }
+        Loaded[I] = std::move(*Diags);
+        for (const LoadedDiagnostic &D : Loaded[I]) {
+          Keys[I].emplace_back();
+          llvm::raw_string_ostream OS(Keys[I].back());
+          writeKey(D, OS);
+        }
+      });
+    }
+    Pool.wait();
+  }
+
+  for (unsigned I = 0, E = Files.size(); I != E; ++I)
+    if (Errors[I])
+      return llvm::make_error<llvm::StringError>(
+          Files[I] + ": " + Errors[I].message(), Errors[I]);
+
+  // Merge in input order, so that the result does not depend on scheduling.
+  MergedDiagnostics Result;
+  llvm::StringSet<> Seen;
+  for (unsigned I = 0, E = Files.size(); I != E; ++I) {
+    for (unsigned J = 0, N = Loaded[I].size(); J != N; ++J) {
+      if (!Seen.insert(Keys[I][J]).second) {
+        ++Result.NumDuplicates;
+        continue;
+      }
+      Result.Diagnostics.push_back(std::move(Loaded[I][J]));
+    }
+    Loaded[I].clear();
+    Keys[I].clear();
+  }
+
+  std::stable_sort(Result.Diagnostics.begin(), Result.Diagnostics.end(),
+                   [](const LoadedDiagnostic &LHS,
+                      const LoadedDiagnostic &RHS) {
+                     return LHS.Loc.Filename < RHS.Loc.Filename;
+                   });
+
+  for (unsigned I = 0, E = Result.Diagnostics.size(); I != E; ++I) {
+    auto &Range = Result.FileRanges[Result.Diagnostics[I].Loc.Filename];
+    if (Range.second == 0)
+      Range.first = I;
+    ++Range.second;
+  }
+
+  return std::move(Result);
+}
+
+ArrayRef<LoadedDiagnostic>
+MergedDiagnostics::getDiagnosticsForFile(StringRef File) const {
+  auto Known = FileRanges.find(File);
+  if (Known == FileRanges.end())
+    return None;
+  return diagnostics().slice(Known->second.first, Known->second.second);
+}
+
+std::error_code MergedDiagnostics::write(StringRef OutputFile) const {
+  return writeIndexed(OutputFile, Diagnostics);
+}
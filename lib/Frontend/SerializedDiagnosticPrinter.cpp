@@ -12,6 +12,7 @@
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/DiagnosticRenderer.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/SerializedDiagnosticIndex.h"
 #include "clang/Frontend/SerializedDiagnosticReader.h"
 #include "clang/Frontend/SerializedDiagnostics.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
@@ -19,8 +20,10 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/raw_ostream.h"
+#include <tuple>
 #include <utility>
 
 using namespace clang;
@@ -132,6 +135,7 @@ private:
 class SDiagsWriter : public DiagnosticConsumer {
   friend class SDiagsRenderer;
   friend class SDiagsMerger;
+  friend class SDiagsIndexedWriter;
 
   struct SharedState;
 
@@ -288,6 +292,41 @@ private:
   /// State shared among the various clones of this diagnostic consumer.
   std::shared_ptr<SharedState> State;
 };
+
+/// Writes already-loaded diagnostics, grouped by file, followed by an index
+/// block that locates each file's diagnostics.
+class SDiagsIndexedWriter {
+  SDiagsWriter Writer;
+
+  /// The IDs of file and flag names, which are unique across the output.
+  llvm::StringMap<unsigned> FileIDs;
+  llvm::StringMap<unsigned> FlagIDs;
+
+  /// The file, flag and category records emitted in the current run of
+  /// diagnostics.
+  llvm::DenseSet<unsigned> EmittedFiles;
+  llvm::DenseSet<unsigned> EmittedFlags;
+  llvm::DenseSet<unsigned> EmittedCategories;
+
+public:
+  SDiagsIndexedWriter(StringRef OutputFile)
+      : Writer(OutputFile, new DiagnosticOptions(),
+               /*MergeChildRecords=*/false) {}
+
+  std::error_code write(ArrayRef<LoadedDiagnostic> Diags);
+
+private:
+  void emitDiagnostic(const LoadedDiagnostic &D);
+  uint64_t emitIndexLocationBlock();
+  void emitIndexBlock(
+      ArrayRef<std::tuple<StringRef, uint64_t, unsigned>> Index);
+
+  unsigned getEmitFile(StringRef Name);
+  unsigned getEmitCategory(unsigned ID, StringRef Name);
+  unsigned getEmitDiagnosticFlag(StringRef Name);
+
+  void addLocToRecord(const LoadedLocation &Loc, RecordDataImpl &Record);
+};
 } // end anonymous namespace
 
 namespace clang {
@@ -297,6 +336,11 @@ create(StringRef OutputFile, DiagnosticOptions *Diags, bool MergeChildRecords) {
   return llvm::make_unique<SDiagsWriter>(OutputFile, Diags, MergeChildRecords);
 }
 
+std::error_code writeIndexed(StringRef OutputFile,
+                             ArrayRef<LoadedDiagnostic> Diags) {
+  return SDiagsIndexedWriter(OutputFile).write(Diags);
+}
+
 } // end namespace serialized_diags
 } // end namespace clang
 
@@ -855,3 +899,175 @@ std::error_code SDiagsMerger::visitDiagFlagRecord(unsigned ID, StringRef Name) {
   DiagFlagLookup[ID] = Writer.getEmitDiagnosticFlag(Name);
   return std::error_code();
 }
+
+std::error_code SDiagsIndexedWriter::write(ArrayRef<LoadedDiagnostic> Diags) {
+  llvm::BitstreamWriter &Stream = Writer.State->Stream;
+
+  uint64_t IndexLocationBit = emitIndexLocationBlock();
+
+  // The file name, bit offset and size of each run of diagnostics.
+  std::vector<std::tuple<StringRef, uint64_t, unsigned>> Index;
+  for (const LoadedDiagnostic &D : Diags) {
+    if (Index.empty() || std::get<0>(Index.back()) != D.Loc.Filename) {
+      // Start a new run, and make it self-contained.
+      EmittedFiles.clear();
+      EmittedFlags.clear();
+      EmittedCategories.clear();
+      Index.emplace_back(D.Loc.Filename, Stream.GetCurrentBitNo(), 0);
+    }
+    ++std::get<2>(Index.back());
+    emitDiagnostic(D);
+  }
+  uint64_t IndexBit = Stream.GetCurrentBitNo();
+  emitIndexBlock(Index);
+  Stream.BackpatchWord(IndexLocationBit, static_cast<uint32_t>(IndexBit));
+  Stream.BackpatchWord(IndexLocationBit + 32,
+                       static_cast<uint32_t>(IndexBit >> 32));
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Writer.State->OutputFile, EC, llvm::sys::fs::F_None);
+  if (EC)
+    return EC;
+  OS.write(Writer.State->Buffer.data(), Writer.State->Buffer.size());
+  OS.close();
+  return OS.error();
+}
+
+void SDiagsIndexedWriter::emitDiagnostic(const LoadedDiagnostic &D) {
+  llvm::BitstreamWriter &Stream = Writer.State->Stream;
+  AbbreviationMap &Abbrevs = Writer.State->Abbrevs;
+
+  Writer.EnterDiagBlock();
+
+  RecordData Record;
+  Record.push_back(RECORD_DIAG);
+  Record.push_back(D.Severity);
+  addLocToRecord(D.Loc, Record);
+  Record.push_back(getEmitCategory(D.Category, D.CategoryName));
+  Record.push_back(getEmitDiagnosticFlag(D.Flag));
+  Record.push_back(D.Message.size());
+  Stream.EmitRecordWithBlob(Abbrevs.get(RECORD_DIAG), Record, D.Message);
+
+  for (const auto &Range : D.Ranges) {
+    Record.clear();
+    Record.push_back(RECORD_SOURCE_RANGE);
+    addLocToRecord(Range.first, Record);
+    addLocToRecord(Range.second, Record);
+    Stream.EmitRecordWithAbbrev(Abbrevs.get(RECORD_SOURCE_RANGE), Record);
+  }
+
+  for (const LoadedDiagnostic::FixIt &Fix : D.FixIts) {
+    Record.clear();
+    Record.push_back(RECORD_FIXIT);
+    addLocToRecord(Fix.Start, Record);
+    addLocToRecord(Fix.End, Record);
+    Record.push_back(Fix.Text.size());
+    Stream.EmitRecordWithBlob(Abbrevs.get(RECORD_FIXIT), Record, Fix.Text);
+  }
+
+  for (const LoadedDiagnostic &Child : D.Children)
+    emitDiagnostic(Child);
+
+  Writer.ExitDiagBlock();
+}
+
+/// Emits the index location block with a placeholder for the bit offset of
+/// the index block, and returns the bit offset of the placeholder.
+uint64_t SDiagsIndexedWriter::emitIndexLocationBlock() {
+  using namespace llvm;
+  BitstreamWriter &Stream = Writer.State->Stream;
+
+  Stream.EnterSubblock(BLOCK_INDEX_LOCATION, 3);
+
+  auto Abbrev = std::make_shared<BitCodeAbbrev>();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_INDEX_LOCATION));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Index bit offset.
+  unsigned LocationAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+  // A blob starts on a 32-bit boundary, so the words of the placeholder can
+  // be backpatched once the offset is known.
+  const char Placeholder[sizeof(uint64_t)] = {};
+  RecordData::value_type Record[] = {RECORD_INDEX_LOCATION};
+  Stream.EmitRecordWithBlob(LocationAbbrev, Record,
+                            StringRef(Placeholder, sizeof(Placeholder)));
+  uint64_t PlaceholderBit = Stream.GetCurrentBitNo() - 64;
+
+  Stream.ExitBlock();
+  return PlaceholderBit;
+}
+
+void SDiagsIndexedWriter::emitIndexBlock(
+    ArrayRef<std::tuple<StringRef, uint64_t, unsigned>> Index) {
+  using namespace llvm;
+  BitstreamWriter &Stream = Writer.State->Stream;
+
+  Stream.EnterSubblock(BLOCK_INDEX, 3);
+
+  auto Abbrev = std::make_shared<BitCodeAbbrev>();
+  Abbrev->Add(BitCodeAbbrevOp(RECORD_INDEX_FILE));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Bit offset.
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8));  // Diag count.
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 16)); // Text size.
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));    // File name text.
+  unsigned IndexAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+  for (const auto &Entry : Index) {
+    StringRef Name = std::get<0>(Entry);
+    RecordData::value_type Record[] = {RECORD_INDEX_FILE, std::get<1>(Entry),
+                                       std::get<2>(Entry), Name.size()};
+    Stream.EmitRecordWithBlob(IndexAbbrev, Record, Name);
+  }
+
+  Stream.ExitBlock();
+}
+
+unsigned SDiagsIndexedWriter::getEmitFile(StringRef Name) {
+  if (Name.empty())
+    return 0;
+
+  unsigned &ID = FileIDs[Name];
+  if (!ID)
+    ID = FileIDs.size();
+  if (!EmittedFiles.insert(ID).second)
+    return ID;
+
+  RecordData::value_type Record[] = {RECORD_FILENAME, ID, 0 /* For legacy */,
+                                     0 /* For legacy */, Name.size()};
+  Writer.State->Stream.EmitRecordWithBlob(
+      Writer.State->Abbrevs.get(RECORD_FILENAME), Record, Name);
+  return ID;
+}
+
+unsigned SDiagsIndexedWriter::getEmitCategory(unsigned ID, StringRef Name) {
+  if (!EmittedCategories.insert(ID).second)
+    return ID;
+
+  RecordData::value_type Record[] = {RECORD_CATEGORY, ID, Name.size()};
+  Writer.State->Stream.EmitRecordWithBlob(
+      Writer.State->Abbrevs.get(RECORD_CATEGORY), Record, Name);
+  return ID;
+}
+
+unsigned SDiagsIndexedWriter::getEmitDiagnosticFlag(StringRef Name) {
+  if (Name.empty())
+    return 0;
+
+  unsigned &ID = FlagIDs[Name];
+  if (!ID)
+    ID = FlagIDs.size();
+  if (!EmittedFlags.insert(ID).second)
+    return ID;
+
+  RecordData::value_type Record[] = {RECORD_DIAG_FLAG, ID, Name.size()};
+  Writer.State->Stream.EmitRecordWithBlob(
+      Writer.State->Abbrevs.get(RECORD_DIAG_FLAG), Record, Name);
+  return ID;
+}
+
+void SDiagsIndexedWriter::addLocToRecord(const LoadedLocation &Loc,
+                                         RecordDataImpl &Record) {
+  Record.push_back(getEmitFile(Loc.Filename));
+  Record.push_back(Loc.Line);
+  Record.push_back(Loc.Col);
+  Record.push_back(Loc.Offset);
+}
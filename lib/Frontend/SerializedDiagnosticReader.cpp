@@ -16,6 +16,7 @@
 #include "llvm/Bitcode/BitCodes.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -25,6 +26,21 @@
 using namespace clang;
 using namespace serialized_diags;
 
+std::error_code
+SerializedDiagnosticReader::readSignature(llvm::BitstreamCursor &Stream) {
+  if (Stream.AtEndOfStream())
+    return SDError::InvalidSignature;
+
+  // Sniff for the signature.
+  if (Stream.Read(8) != 'D' ||
+      Stream.Read(8) != 'I' ||
+      Stream.Read(8) != 'A' ||
+      Stream.Read(8) != 'G')
+    return SDError::InvalidSignature;
+
+  return {};
+}
+
 std::error_code SerializedDiagnosticReader::readDiagnostics(StringRef File) {
   // Open the diagnostics file.
   FileSystemOptions FO;
@@ -37,22 +53,15 @@ std::error_code SerializedDiagnosticReader::readDiagnostics(StringRef File) {
   llvm::BitstreamCursor Stream(**Buffer);
   Optional<llvm::BitstreamBlockInfo> BlockInfo;
 
-  if (Stream.AtEndOfStream())
-    return SDError::InvalidSignature;
-
-  // Sniff for the signature.
-  if (Stream.Read(8) != 'D' ||
-      Stream.Read(8) != 'I' ||
-      Stream.Read(8) != 'A' ||
-      Stream.Read(8) != 'G')
-    return SDError::InvalidSignature;
+  std::error_code EC;
+  if ((EC = readSignature(Stream)))
+    return EC;
 
   // Read the top level blocks.
   while (!Stream.AtEndOfStream()) {
     if (Stream.ReadCode() != llvm::bitc::ENTER_SUBBLOCK)
       return SDError::InvalidDiagnostics;
 
-    std::error_code EC;
     switch (Stream.ReadSubBlockID()) {
     case llvm::bitc::BLOCKINFO_BLOCK_ID:
       BlockInfo = Stream.ReadBlockInfoBlock();
@@ -69,11 +78,92 @@ std::error_code SerializedDiagnosticReader::readDiagnostics(StringRef File) {
         return EC;
       continue;
     default:
-      if (!Stream.SkipBlock())
+      if (Stream.SkipBlock())
+        return SDError::MalformedTopLevelBlock;
+      continue;
+    }
+  }
+  return {};
+}
+
+std::error_code
+SerializedDiagnosticReader::readDiagnosticsForFile(StringRef File,
+                                                   StringRef SourceFile) {
+  FileSystemOptions FO;
+  FileManager FileMgr(FO);
+
+  auto Buffer = FileMgr.getBufferForFile(File);
+  if (!Buffer)
+    return SDError::CouldNotLoad;
+
+  llvm::BitstreamCursor Stream(**Buffer);
+  Optional<llvm::BitstreamBlockInfo> BlockInfo;
+
+  std::error_code EC;
+  if ((EC = readSignature(Stream)))
+    return EC;
+
+  // The index is written after the diagnostics, and the index location block
+  // before them records where it starts, so the diagnostics are not read
+  // until the index says which of them to read. Without a location block,
+  // skip over the diagnostics to find the index.
+  Optional<std::pair<uint64_t, unsigned>> Entry;
+  while (!Entry && !Stream.AtEndOfStream()) {
+    if (Stream.ReadCode() != llvm::bitc::ENTER_SUBBLOCK)
+      return SDError::InvalidDiagnostics;
+
+    switch (Stream.ReadSubBlockID()) {
+    case llvm::bitc::BLOCKINFO_BLOCK_ID:
+      BlockInfo = Stream.ReadBlockInfoBlock();
+      if (!BlockInfo)
+        return SDError::MalformedBlockInfoBlock;
+      Stream.setBlockInfo(&*BlockInfo);
+      continue;
+    case BLOCK_META:
+      if ((EC = readMetaBlock(Stream)))
+        return EC;
+      continue;
+    case BLOCK_INDEX: {
+      llvm::ErrorOr<std::pair<uint64_t, unsigned>> Res =
+          readIndexBlock(Stream, SourceFile);
+      if (!Res)
+        return Res.getError();
+      Entry = *Res;
+      continue;
+    }
+    case BLOCK_INDEX_LOCATION: {
+      llvm::ErrorOr<uint64_t> IndexBit = readIndexLocationBlock(Stream);
+      if (!IndexBit)
+        return IndexBit.getError();
+      if (!Stream.canSkipToPos(*IndexBit / 8))
+        return SDError::MalformedTopLevelBlock;
+      Stream.JumpToBit(*IndexBit);
+      continue;
+    }
+    default:
+      if (Stream.SkipBlock())
         return SDError::MalformedTopLevelBlock;
       continue;
     }
   }
+
+  if (!Entry)
+    return SDError::MissingIndex;
+
+  // The diagnostics for a file are contiguous, and each run of them repeats
+  // the file, category and flag records it refers to, so they can be read
+  // without looking at any other diagnostic.
+  if (Entry->second == 0)
+    return {};
+  Stream.JumpToBit(Entry->first);
+  for (unsigned I = 0; I != Entry->second; ++I) {
+    if (Stream.AtEndOfStream() ||
+        Stream.ReadCode() != llvm::bitc::ENTER_SUBBLOCK ||
+        Stream.ReadSubBlockID() != BLOCK_DIAG)
+      return SDError::MalformedTopLevelBlock;
+    if ((EC = readDiagnosticBlock(Stream)))
+      return EC;
+  }
   return {};
 }
 
@@ -179,7 +269,7 @@ SerializedDiagnosticReader::readDiagnosticBlock(llvm::BitstreamCursor &Stream) {
       if (BlockOrCode == serialized_diags::BLOCK_DIAG) {
         if ((EC = readDiagnosticBlock(Stream)))
           return EC;
-      } else if (!Stream.SkipBlock())
+      } else if (Stream.SkipBlock())
         return SDError::MalformedSubBlock;
       continue;
     case Cursor::BlockEnd:
@@ -261,6 +351,84 @@ SerializedDiagnosticReader::readDiagnosticBlock(llvm::BitstreamCursor &Stream) {
   }
 }
 
+llvm::ErrorOr<std::pair<uint64_t, unsigned>>
+SerializedDiagnosticReader::readIndexBlock(llvm::BitstreamCursor &Stream,
+                                           StringRef SourceFile) {
+  if (Stream.EnterSubBlock(clang::serialized_diags::BLOCK_INDEX))
+    return SDError::MalformedTopLevelBlock;
+
+  std::pair<uint64_t, unsigned> Result(0, 0);
+  SmallVector<uint64_t, 2> Record;
+  while (true) {
+    unsigned BlockOrCode = 0;
+    llvm::ErrorOr<Cursor> Res = skipUntilRecordOrBlock(Stream, BlockOrCode);
+    if (!Res)
+      return Res.getError();
+
+    switch (Res.get()) {
+    case Cursor::BlockBegin:
+      if (Stream.SkipBlock())
+        return SDError::MalformedSubBlock;
+      continue;
+    case Cursor::BlockEnd:
+      return Result;
+    case Cursor::Record:
+      break;
+    }
+
+    Record.clear();
+    StringRef Blob;
+    unsigned RecID = Stream.readRecord(BlockOrCode, Record, &Blob);
+    if (RecID != RECORD_INDEX_FILE)
+      continue;
+
+    // An index entry has an offset, a count and the file name size.
+    if (Record.size() != 3)
+      return SDError::MalformedDiagnosticRecord;
+    if (Blob == SourceFile)
+      Result = std::make_pair(Record[0], static_cast<unsigned>(Record[1]));
+  }
+}
+
+llvm::ErrorOr<uint64_t>
+SerializedDiagnosticReader::readIndexLocationBlock(
+    llvm::BitstreamCursor &Stream) {
+  if (Stream.EnterSubBlock(clang::serialized_diags::BLOCK_INDEX_LOCATION))
+    return SDError::MalformedTopLevelBlock;
+
+  Optional<uint64_t> IndexBit;
+  SmallVector<uint64_t, 1> Record;
+  while (true) {
+    unsigned BlockOrCode = 0;
+    llvm::ErrorOr<Cursor> Res = skipUntilRecordOrBlock(Stream, BlockOrCode);
+    if (!Res)
+      return Res.getError();
+
+    switch (Res.get()) {
+    case Cursor::BlockBegin:
+      if (Stream.SkipBlock())
+        return SDError::MalformedSubBlock;
+      continue;
+    case Cursor::BlockEnd:
+      if (!IndexBit)
+        return SDError::MissingIndex;
+      return *IndexBit;
+    case Cursor::Record:
+      break;
+    }
+
+    Record.clear();
+    StringRef Blob;
+    unsigned RecID = Stream.readRecord(BlockOrCode, Record, &Blob);
+    if (RecID != RECORD_INDEX_LOCATION)
+      continue;
+
+    if (Blob.size() != sizeof(uint64_t))
+      return SDError::MalformedDiagnosticRecord;
+    IndexBit = llvm::support::endian::read64le(Blob.data());
+  }
+}
+
 namespace {
 
 class SDErrorCategoryType final : public std::error_category {
@@ -295,6 +463,8 @@ class SDErrorCategoryType final : public std::error_category {
       return "Unsupported diagnostics version";
     case SDError::UnsupportedConstruct:
       return "Bitcode constructs that are not supported in diagnostics appear";
+    case SDError::MissingIndex:
+      return "No index provided in diagnostics";
     case SDError::HandlerFailed:
       return "Generic error occurred while handling a record";
     }
@@ -0,0 +1,447 @@
+//===--- UnusedIncludes.cpp - Find the includes that are not used --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This code finds the #include directives of the main file that nothing is
+// used from, warns about them with a fix-it that removes them, and can write
+// them to a JSON report.
+//
+// A header counts as used if the main file, or a header it includes through
+// another directive, refers to a declaration or a macro written in that
+// header or in a header that it includes. Uses of macros are seen by the
+// preprocessor. Uses of declarations are collected from the AST of the main
+// file and of the headers it includes, which holds the declarations Sema
+// resolved each name, type, member, conversion and overloaded operator to,
+// and the library declarations that 'new', 'typeid' and initializer lists
+// need.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/DeclGroup.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Lex/MacroInfo.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+
+namespace {
+
+/// An #include directive written in the main file.
+struct IncludeDirective {
+  SourceLocation HashLoc;
+
+  /// The file name as written, with its quotes or angle brackets.
+  std::string Spelling;
+  const FileEntry *File;
+
+  /// Whether the header was entered. Headers skipped because of their
+  /// include guard are never reported, since they may be relied on by the
+  /// headers that included them first.
+  bool Entered = false;
+  bool Used = false;
+};
+
+class IncludeUseCollector : public PPCallbacks {
+  const SourceManager &SM;
+  std::vector<IncludeDirective> Directives;
+
+  /// The directive of the main file that each entered file was included
+  /// through.
+  llvm::DenseMap<FileID, unsigned> FileDirectives;
+
+  /// The directive whose header is about to be entered.
+  Optional<unsigned> Pending;
+
+  void markMacroUsed(SourceLocation UseLoc, const MacroDefinition &MD) {
+    if (const MacroInfo *MI = MD.getMacroInfo())
+      markUsed(UseLoc, MI->getDefinitionLoc());
+  }
+
+public:
+  explicit IncludeUseCollector(const SourceManager &SM) : SM(SM) {}
+
+  ArrayRef<IncludeDirective> getDirectives() const { return Directives; }
+
+  /// Returns the directive of the main file that the file \p Loc is written
+  /// in was included through, if any.
+  Optional<unsigned> getDirective(SourceLocation Loc) const {
+    auto Known = FileDirectives.find(SM.getFileID(SM.getExpansionLoc(Loc)));
+    if (Known == FileDirectives.end())
+      return None;
+    return Known->second;
+  }
+
+  /// Records that something written at \p DeclLoc is used at \p UseLoc.
+  /// Uses from the same directive as the declaration do not count.
+  void markUsed(SourceLocation UseLoc, SourceLocation DeclLoc) {
+    if (DeclLoc.isInvalid())
+      return;
+    Optional<unsigned> Declared = getDirective(DeclLoc);
+    if (Declared && getDirective(UseLoc) != Declared)
+      Directives[*Declared].Used = true;
+  }
+
+  void InclusionDirective(SourceLocation HashLoc, const Token &IncludeTok,
+                          StringRef FileName, bool IsAngled,
+                          CharSourceRange FilenameRange, const FileEntry *File,
+                          StringRef SearchPath, StringRef RelativePath,
+                          const Module *Imported,
+                          SrcMgr::CharacteristicKind FileType) override;
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override;
+
+  void FileSkipped(const FileEntryRef &SkippedFile, const Token &FilenameTok,
+                   SrcMgr::CharacteristicKind FileType) override {
+    Pending.reset();
+  }
+
+  void MacroExpands(const Token &MacroNameTok, const MacroDefinition &MD,
+                    SourceRange Range, const MacroArgs *Args) override {
+    markMacroUsed(MacroNameTok.getLocation(), MD);
+  }
+
+  void Defined(const Token &MacroNameTok, const MacroDefinition &MD,
+               SourceRange Range) override {
+    markMacroUsed(MacroNameTok.getLocation(), MD);
+  }
+
+  void Ifdef(SourceLocation Loc, const Token &MacroNameTok,
+             const MacroDefinition &MD) override {
+    markMacroUsed(MacroNameTok.getLocation(), MD);
+  }
+
+  void Ifndef(SourceLocation Loc, const Token &MacroNameTok,
+              const MacroDefinition &MD) override {
+    markMacroUsed(MacroNameTok.getLocation(), MD);
+  }
+};
+
+/// Marks the headers that declare what a declaration refers to as used.
+class IncludeUseFinder : public RecursiveASTVisitor<IncludeUseFinder> {
+  IncludeUseCollector &Collector;
+
+  void use(SourceLocation UseLoc, const Decl *D) {
+    // Namespaces are reopened by most headers, so using one says nothing.
+    if (D && !isa<NamespaceDecl>(D))
+      Collector.markUsed(UseLoc, D->getLocation());
+  }
+
+  /// Uses the class a type names, such as the std::type_info of a 'typeid'
+  /// or the std::initializer_list of a braced list, which is never spelled.
+  void useType(SourceLocation UseLoc, QualType T) {
+    use(UseLoc, T->getAsCXXRecordDecl());
+  }
+
+public:
+  explicit IncludeUseFinder(IncludeUseCollector &Collector)
+      : Collector(Collector) {}
+
+  /// Implicit code, such as the begin() and end() calls of a range-based for
+  /// loop, uses declarations too.
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool VisitDecl(Decl *D) {
+    // A definition needs the declarations it redeclares to stay visible.
+    for (const Decl *Prev = D->getPreviousDecl(); Prev;
+         Prev = Prev->getPreviousDecl())
+      use(D->getLocation(), Prev);
+    return true;
+  }
+
+  bool VisitUsingDecl(UsingDecl *D) {
+    for (const UsingShadowDecl *Shadow : D->shadows())
+      use(D->getLocation(), Shadow->getTargetDecl());
+    return true;
+  }
+
+  bool VisitDeclRefExpr(DeclRefExpr *E) {
+    use(E->getLocation(), E->getDecl());
+    use(E->getLocation(), E->getFoundDecl());
+    return true;
+  }
+
+  bool VisitMemberExpr(MemberExpr *E) {
+    use(E->getMemberLoc(), E->getMemberDecl());
+    use(E->getMemberLoc(), E->getFoundDecl().getDecl());
+    return true;
+  }
+
+  bool VisitOverloadExpr(OverloadExpr *E) {
+    // Any of the candidates may be the one picked once the template is
+    // instantiated.
+    for (const NamedDecl *Candidate : E->decls())
+      use(E->getNameLoc(), Candidate);
+    return true;
+  }
+
+  bool VisitCXXConstructExpr(CXXConstructExpr *E) {
+    use(E->getLocation(), E->getConstructor());
+    return true;
+  }
+
+  bool VisitCXXNewExpr(CXXNewExpr *E) {
+    // The placement forms are declared in <new>.
+    use(E->getBeginLoc(), E->getOperatorNew());
+    use(E->getBeginLoc(), E->getOperatorDelete());
+    return true;
+  }
+
+  bool VisitCXXDeleteExpr(CXXDeleteExpr *E) {
+    use(E->getBeginLoc(), E->getOperatorDelete());
+    return true;
+  }
+
+  bool VisitCXXTypeidExpr(CXXTypeidExpr *E) {
+    useType(E->getBeginLoc(), E->getType());
+    return true;
+  }
+
+  bool VisitCXXStdInitializerListExpr(CXXStdInitializerListExpr *E) {
+    useType(E->getBeginLoc(), E->getType());
+    return true;
+  }
+
+  bool VisitObjCMessageExpr(ObjCMessageExpr *E) {
+    use(E->getSelectorStartLoc(), E->getMethodDecl());
+    return true;
+  }
+
+  bool VisitObjCIvarRefExpr(ObjCIvarRefExpr *E) {
+    use(E->getLocation(), E->getDecl());
+    return true;
+  }
+
+  bool VisitObjCPropertyRefExpr(ObjCPropertyRefExpr *E) {
+    if (E->isExplicitProperty())
+      use(E->getLocation(), E->getExplicitProperty());
+    else
+      use(E->getLocation(), E->getImplicitPropertyGetter());
+    return true;
+  }
+
+  bool VisitTagTypeLoc(TagTypeLoc TL) {
+    use(TL.getNameLoc(), TL.getDecl());
+    return true;
+  }
+
+  bool VisitTypedefTypeLoc(TypedefTypeLoc TL) {
+    use(TL.getNameLoc(), TL.getTypedefNameDecl());
+    return true;
+  }
+
+  bool VisitTemplateSpecializationTypeLoc(TemplateSpecializationTypeLoc TL) {
+    use(TL.getTemplateNameLoc(),
+        TL.getTypePtr()->getTemplateName().getAsTemplateDecl());
+    // An explicit or partial specialization may live in another header than
+    // the template it specializes.
+    if (const auto *Spec = dyn_cast_or_null<ClassTemplateSpecializationDecl>(
+            TL.getTypePtr()->getAsCXXRecordDecl())) {
+      use(TL.getTemplateNameLoc(), Spec);
+      auto Pattern = Spec->getSpecializedTemplateOrPartial();
+      use(TL.getTemplateNameLoc(),
+          Pattern.dyn_cast<ClassTemplatePartialSpecializationDecl *>());
+    }
+    return true;
+  }
+
+  bool VisitDeducedTemplateSpecializationTypeLoc(
+      DeducedTemplateSpecializationTypeLoc TL) {
+    use(TL.getTemplateNameLoc(),
+        TL.getTypePtr()->getTemplateName().getAsTemplateDecl());
+    return true;
+  }
+
+  bool VisitObjCInterfaceTypeLoc(ObjCInterfaceTypeLoc TL) {
+    use(TL.getNameLoc(), TL.getIFaceDecl());
+    return true;
+  }
+
+  bool VisitObjCObjectTypeLoc(ObjCObjectTypeLoc TL) {
+    for (unsigned I = 0, E = TL.getNumProtocols(); I != E; ++I)
+      use(TL.getProtocolLoc(I), TL.getProtocol(I));
+    return true;
+  }
+};
+
+class UnusedIncludeReporter : public ASTConsumer {
+  Preprocessor &PP;
+  std::string OutputFile;
+
+  /// Owned by the preprocessor, which outlives parsing.
+  IncludeUseCollector *Collector;
+
+  /// The top level declarations written in the main file, or in a header
+  /// entered through one of its directives, whose uses may keep another
+  /// directive alive.
+  std::vector<Decl *> Decls;
+
+public:
+  UnusedIncludeReporter(Preprocessor &PP, StringRef OutputFile)
+      : PP(PP), OutputFile(OutputFile) {
+    auto Callbacks =
+        llvm::make_unique<IncludeUseCollector>(PP.getSourceManager());
+    Collector = Callbacks.get();
+    PP.addPPCallbacks(std::move(Callbacks));
+  }
+
+  bool HandleTopLevelDecl(DeclGroupRef DG) override {
+    const SourceManager &SM = PP.getSourceManager();
+    for (Decl *D : DG) {
+      SourceLocation Loc = SM.getExpansionLoc(D->getLocation());
+      if (SM.isWrittenInMainFile(Loc) || Collector->getDirective(Loc))
+        Decls.push_back(D);
+    }
+    return true;
+  }
+
+  void HandleTopLevelDeclInObjCContainer(DeclGroupRef DG) override {
+    HandleTopLevelDecl(DG);
+  }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override;
+};
+
+} // end anonymous namespace
+
+void IncludeUseCollector::InclusionDirective(
+    SourceLocation HashLoc, const Token &IncludeTok, StringRef FileName,
+    bool IsAngled, CharSourceRange FilenameRange, const FileEntry *File,
+    StringRef SearchPath, StringRef RelativePath, const Module *Imported,
+    SrcMgr::CharacteristicKind FileType) {
+  Pending.reset();
+  if (!File || Imported || !SM.isWrittenInMainFile(HashLoc))
+    return;
+
+  IncludeDirective Directive;
+  Directive.HashLoc = HashLoc;
+  Directive.Spelling =
+      (IsAngled ? "<" + FileName + ">" : "\"" + FileName + "\"").str();
+  Directive.File = File;
+  Pending = Directives.size();
+  Directives.push_back(std::move(Directive));
+}
+
+void IncludeUseCollector::FileChanged(SourceLocation Loc,
+                                      FileChangeReason Reason,
+                                      SrcMgr::CharacteristicKind FileType,
+                                      FileID PrevFID) {
+  if (Reason != EnterFile)
+    return;
+  FileID FID = SM.getFileID(Loc);
+  SourceLocation IncludeLoc = SM.getIncludeLoc(FID);
+  if (IncludeLoc.isInvalid())
+    return;
+
+  if (SM.getFileID(IncludeLoc) == SM.getMainFileID()) {
+    if (Pending) {
+      FileDirectives[FID] = *Pending;
+      Directives[*Pending].Entered = true;
+      Pending.reset();
+    }
+    return;
+  }
+
+  // Headers included by the header of a directive belong to that directive.
+  if (Optional<unsigned> Directive = getDirective(IncludeLoc))
+    FileDirectives[FID] = *Directive;
+}
+
+/// Returns the range that removes the directive at \p HashLoc, together with
+/// its line if nothing else is written on it.
+static CharSourceRange getDirectiveRange(const SourceManager &SM,
+                                         SourceLocation HashLoc) {
+  std::pair<FileID, unsigned> Decomposed = SM.getDecomposedLoc(HashLoc);
+  bool Invalid = false;
+  StringRef Buffer = SM.getBufferData(Decomposed.first, &Invalid);
+  if (Invalid)
+    return CharSourceRange();
+
+  size_t Begin = Decomposed.second;
+  while (Begin > 0 && isHorizontalWhitespace(Buffer[Begin - 1]))
+    --Begin;
+  bool StartsLine = Begin == 0 || isVerticalWhitespace(Buffer[Begin - 1]);
+
+  size_t End = Buffer.find_first_of("\r\n", Decomposed.second);
+  if (End == StringRef::npos) {
+    End = Buffer.size();
+  } else if (StartsLine) {
+    // Take the line break along, so that no empty line is left behind.
+    if (Buffer.substr(End).startswith("\r\n"))
+      ++End;
+    ++End;
+  }
+
+  SourceLocation FileStart = SM.getLocForStartOfFile(Decomposed.first);
+  return CharSourceRange::getCharRange(
+      FileStart.getLocWithOffset(StartsLine ? Begin : Decomposed.second),
+      FileStart.getLocWithOffset(End));
+}
+
+void UnusedIncludeReporter::HandleTranslationUnit(ASTContext &Ctx) {
+  // Declarations that failed to parse may have dropped their uses.
+  DiagnosticsEngine &Diags = PP.getDiagnostics();
+  if (Diags.hasErrorOccurred())
+    return;
+
+  IncludeUseFinder Finder(*Collector);
+  for (Decl *D : Decls)
+    Finder.TraverseDecl(D);
+
+  const SourceManager &SM = PP.getSourceManager();
+  llvm::json::Array Unused;
+  for (const IncludeDirective &Directive : Collector->getDirectives()) {
+    if (!Directive.Entered || Directive.Used)
+      continue;
+
+    CharSourceRange Range = getDirectiveRange(SM, Directive.HashLoc);
+    Diags.Report(Directive.HashLoc, diag::warn_fe_unused_include)
+        << Directive.Spelling << FixItHint::CreateRemoval(Range);
+
+    if (OutputFile.empty() || Range.isInvalid())
+      continue;
+    unsigned Begin = SM.getFileOffset(Range.getBegin());
+    Unused.push_back(llvm::json::Object{
+        {"include", Directive.Spelling},
+        {"file", Directive.File->getName()},
+        {"line", SM.getSpellingLineNumber(Directive.HashLoc)},
+        {"offset", Begin},
+        {"length", SM.getFileOffset(Range.getEnd()) - Begin}});
+  }
+
+  if (OutputFile.empty())
+    return;
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(OutputFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    Diags.Report(diag::err_fe_error_opening) << OutputFile << EC.message();
+    return;
+  }
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  llvm::json::Value Report = llvm::json::Object{
+      {"main-file", MainFile ? MainFile->getName() : StringRef("<unknown>")},
+      {"unused-includes", std::move(Unused)}};
+  OS << llvm::formatv("{0:2}\n", Report);
+}
+
+std::unique_ptr<ASTConsumer>
+clang::CreateUnusedIncludeReporter(Preprocessor &PP, StringRef OutputFile) {
+  return llvm::make_unique<UnusedIncludeReporter>(PP, OutputFile);
+}
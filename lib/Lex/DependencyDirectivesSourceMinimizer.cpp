@@ -20,6 +20,7 @@
 #include "clang/Lex/LexDiagnostic.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <algorithm>
 
 using namespace llvm;
 using namespace clang;
@@ -953,3 +954,267 @@ bool clang::minimizeSourceToDependencyDirectives(
   Tokens.clear();
   return Minimizer(Output, Tokens, Input, Diags, InputSourceLoc).minimize();
 }
+
+namespace {
+
+/// Replaces comments, and the contents of "#if 0" blocks, with whitespace
+/// while keeping every newline and line continuation in place.
+struct SourceBlanker {
+  enum DirectiveKind {
+    NotADirective,
+    Include,
+    If,
+    IfZero,
+    ElseOrElif,
+    Endif,
+    OtherDirective,
+  };
+
+  const char *const Begin;
+  const char *const End;
+  char *const Out;
+  const bool LineComments;
+  const bool RawStringLiterals;
+
+  /// The nesting depth of conditional directives.
+  unsigned Depth = 0;
+
+  /// The depth of the "#if 0" whose block is being blanked out, or 0.
+  unsigned DisabledDepth = 0;
+
+  /// Set when the input has a construct whose meaning to the preprocessor
+  /// this simple scanner cannot be sure of.
+  bool Unsure = false;
+
+  SourceBlanker(StringRef Input, char *Out, bool LineComments,
+                bool RawStringLiterals)
+      : Begin(Input.begin()), End(Input.end()), Out(Out),
+        LineComments(LineComments), RawStringLiterals(RawStringLiterals) {}
+
+  bool isLineContinuation(const char *Newline) const;
+  void blank(const char *First, const char *const Last);
+  void skipToEndOfLine(const char *&First);
+  bool skipSpaceAndBlockComments(const char *&First);
+  DirectiveKind getDirectiveKind(const char *First);
+  void scanLine(const char *&First, bool InDirective, bool IsInclude,
+                bool BlankAll);
+  bool run();
+};
+
+} // end anonymous namespace
+
+/// Returns true if the newline at \p Newline is escaped by a backslash,
+/// possibly followed by horizontal whitespace.
+bool SourceBlanker::isLineContinuation(const char *Newline) const {
+  const char *Last = findLastNonSpace(Begin, Newline);
+  return Last != Begin && Last[-1] == '\\';
+}
+
+/// Blanks out [First, Last), except for newlines and the backslashes that
+/// escape them.
+void SourceBlanker::blank(const char *First, const char *const Last) {
+  for (; First != Last; ++First) {
+    if (isWhitespace(*First))
+      continue;
+    if (*First == '\\') {
+      const char *Next = First + 1;
+      skipOverSpaces(Next, End);
+      if (Next == End || isVerticalWhitespace(*Next))
+        continue;
+    }
+    Out[First - Begin] = ' ';
+  }
+}
+
+/// Moves \p First to the newline that ends the logical line.
+void SourceBlanker::skipToEndOfLine(const char *&First) {
+  for (;;) {
+    while (First != End && !isVerticalWhitespace(*First))
+      ++First;
+    if (First == End || !isLineContinuation(First))
+      return;
+    skipNewline(First, End);
+  }
+}
+
+/// Skips horizontal whitespace and block comments that end on the same line.
+///
+/// \returns false if a block comment continues onto the next line.
+bool SourceBlanker::skipSpaceAndBlockComments(const char *&First) {
+  for (;;) {
+    skipOverSpaces(First, End);
+    if (End - First < 2 || First[0] != '/' || First[1] != '*')
+      return true;
+    const char *Comment = First;
+    skipBlockComment(First, End);
+    for (; Comment != First; ++Comment)
+      if (isVerticalWhitespace(*Comment))
+        return false;
+  }
+}
+
+SourceBlanker::DirectiveKind
+SourceBlanker::getDirectiveKind(const char *First) {
+  if (!skipSpaceAndBlockComments(First) || First == End || *First != '#')
+    return NotADirective;
+  ++First;
+  if (!skipSpaceAndBlockComments(First))
+    return OtherDirective;
+  const char *NameStart = First;
+  while (First != End && isIdentifierBody(*First))
+    ++First;
+  StringRef Name(NameStart, First - NameStart);
+  DirectiveKind Kind = llvm::StringSwitch<DirectiveKind>(Name)
+                           .Cases("include", "include_next", Include)
+                           .Cases("import", "__include_macros", Include)
+                           .Cases("if", "ifdef", "ifndef", If)
+                           .Cases("elif", "else", ElseOrElif)
+                           .Case("endif", Endif)
+                           .Default(OtherDirective);
+  if (Name != "if")
+    return Kind;
+
+  // Check for "#if 0", followed by nothing but whitespace and comments.
+  if (!skipSpaceAndBlockComments(First) || First == End || *First != '0')
+    return If;
+  ++First;
+  if (!skipSpaceAndBlockComments(First))
+    return If;
+  if (LineComments && End - First >= 2 && First[0] == '/' && First[1] == '/')
+    return IfZero;
+  if (First != End && !isVerticalWhitespace(*First))
+    return If;
+  if (First != End && isLineContinuation(First))
+    return If;
+  return IfZero;
+}
+
+/// Scans the rest of the logical line at \p First, and any block comments
+/// that start on it, and moves \p First past its newline. Comments are
+/// blanked out, or the whole line if \p BlankAll is set.
+void SourceBlanker::scanLine(const char *&First, bool InDirective,
+                             bool IsInclude, bool BlankAll) {
+  const char *const Start = First;
+  while (First != End) {
+    if (isVerticalWhitespace(*First)) {
+      const char *Newline = First;
+      skipNewline(First, End);
+      if (!isLineContinuation(Newline))
+        break;
+      continue;
+    }
+
+    // Iterate over strings correctly to avoid comments and newlines.
+    if (*First == '"' ||
+        (*First == '\'' && !isQuoteCppDigitSeparator(Start, First, End)) ||
+        (IsInclude && *First == '<')) {
+      if (RawStringLiterals && isRawStringLiteral(Start, First)) {
+        skipRawString(First, End);
+        // An unterminated raw string would take the rest of the file along.
+        if (First == End) {
+          Unsure = true;
+          return;
+        }
+      } else {
+        skipString(First, End);
+      }
+      continue;
+    }
+
+    if (*First != '/' || End - First < 2 ||
+        (First[1] != '*' && (First[1] != '/' || !LineComments))) {
+      ++First;
+      continue;
+    }
+
+    const char *const CommentStart = First;
+    if (First[1] == '/') {
+      // "//...".
+      First += 2;
+      skipToEndOfLine(First);
+      blank(CommentStart, First);
+      continue;
+    }
+
+    // "/*...*/".
+    skipBlockComment(First, End);
+    if (First - CommentStart < 4 || First[-2] != '*' || First[-1] != '/') {
+      // An unterminated comment; leave the error to the compiler.
+      Unsure = true;
+      return;
+    }
+    bool IsMultiLine = std::any_of(CommentStart, First, isVerticalWhitespace);
+    if (IsMultiLine) {
+      // Whether a '#' after a comment that spans lines starts a directive
+      // is subtle; don't guess.
+      const char *Next = First;
+      skipOverSpaces(Next, End);
+      if (Next != End && *Next == '#') {
+        Unsure = true;
+        return;
+      }
+      // Turning the comment into newlines would end the directive early.
+      if (InDirective)
+        continue;
+    }
+    blank(CommentStart, First);
+  }
+  if (BlankAll)
+    blank(Start, First);
+}
+
+bool SourceBlanker::run() {
+  // Blanking out a trigraph for a backslash would change the line structure.
+  if (StringRef(Begin, End - Begin).contains("?\?/"))
+    return true;
+
+  const char *First = Begin;
+  skipUTF8ByteOrderMark(First, End);
+  while (First != End && !Unsure) {
+    DirectiveKind Kind = getDirectiveKind(First);
+    bool BlankAll = DisabledDepth != 0;
+    switch (Kind) {
+    case If:
+    case IfZero:
+      ++Depth;
+      if (Kind == IfZero && !DisabledDepth)
+        DisabledDepth = Depth;
+      break;
+    case ElseOrElif:
+      if (DisabledDepth == Depth) {
+        DisabledDepth = 0;
+        BlankAll = false;
+      }
+      break;
+    case Endif:
+      if (DisabledDepth == Depth) {
+        DisabledDepth = 0;
+        BlankAll = false;
+      }
+      if (Depth)
+        --Depth;
+      break;
+    default:
+      break;
+    }
+    scanLine(First, Kind != NotADirective, Kind == Include, BlankAll);
+  }
+  return Unsure;
+}
+
+bool clang::blankOutCommentsAndDisabledBlocks(StringRef Input,
+                                              SmallVectorImpl<char> &Output,
+                                              bool LineComments,
+                                              bool RawStringLiterals) {
+  Output.assign(Input.begin(), Input.end());
+  if (Input.empty())
+    return false;
+  bool Error =
+      SourceBlanker(Input, Output.data(), LineComments, RawStringLiterals)
+          .run();
+
+  // Null-terminate the output, like the minimizer does.
+  Output.push_back(0);
+  Output.pop_back();
+  return Error;
+}
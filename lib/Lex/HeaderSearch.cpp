@@ -95,6 +95,8 @@ void HeaderSearch::PrintStats() {
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+
+  ModMap.PrintStats();
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
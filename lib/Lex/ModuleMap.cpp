@@ -21,6 +21,7 @@
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/Version.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LexDiagnostic.h"
@@ -28,25 +29,33 @@
 #include "clang/Lex/LiteralSupport.h"
 #include "clang/Lex/Token.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <system_error>
 #include <utility>
@@ -1273,6 +1282,11 @@ LLVM_DUMP_METHOD void ModuleMap::dump() {
   }
 }
 
+void ModuleMap::PrintStats() {
+  fprintf(stderr, "%d module map files parsed, %d without lexing.\n",
+          NumModuleMapFilesParsed, NumModuleMapFilesReplayed);
+}
+
 bool ModuleMap::resolveExports(Module *Mod, bool Complain) {
   auto Unresolved = std::move(Mod->UnresolvedExports);
   Mod->UnresolvedExports.clear();
@@ -1420,6 +1434,21 @@ namespace clang {
     /// The current token.
     MMToken Tok;
 
+    /// The tokens of an earlier parse of a module map file with the same
+    /// contents, which are replayed instead of lexing the file, if any.
+    ArrayRef<MMToken> CachedTokens;
+
+    /// The start of the module map file. The locations of cached tokens are
+    /// offsets from it.
+    SourceLocation FileStart;
+
+    /// The tokens lexed so far, if they are to be cached.
+    SmallVectorImpl<MMToken> *LexedTokens;
+
+    /// Whether lexing produced diagnostics, which replaying the tokens would
+    /// not.
+    bool LexingDiagnosed = false;
+
     /// The active module.
     Module *ActiveModule = nullptr;
 
@@ -1471,10 +1500,13 @@ namespace clang {
     explicit ModuleMapParser(Lexer &L, SourceManager &SourceMgr,
                              const TargetInfo *Target, DiagnosticsEngine &Diags,
                              ModuleMap &Map, const FileEntry *ModuleMapFile,
-                             const DirectoryEntry *Directory, bool IsSystem)
+                             const DirectoryEntry *Directory, bool IsSystem,
+                             ArrayRef<MMToken> CachedTokens = None,
+                             SmallVectorImpl<MMToken> *LexedTokens = nullptr)
         : L(L), SourceMgr(SourceMgr), Target(Target), Diags(Diags), Map(Map),
           ModuleMapFile(ModuleMapFile), Directory(Directory),
-          IsSystem(IsSystem) {
+          IsSystem(IsSystem), CachedTokens(CachedTokens),
+          FileStart(L.getSourceLocation()), LexedTokens(LexedTokens) {
       Tok.clear();
       consumeToken();
     }
@@ -1483,13 +1515,223 @@ namespace clang {
 
     bool terminatedByDirective() { return false; }
     SourceLocation getLocation() { return Tok.getLocation(); }
+    bool lexingDiagnosed() { return LexingDiagnosed; }
   };
 
 } // namespace clang
 
+namespace {
+
+/// The tokens of the module map files parsed so far, keyed by the contents of
+/// the files. They are kept in memory for the rest of the process, and are
+/// written to the module cache, if there is one, so that the compilations
+/// that parse the same files later do not have to lex them again.
+class ModuleMapTokenCache {
+public:
+  using KeyTy = std::pair<uint64_t, uint64_t>;
+
+private:
+  struct CachedFile {
+    /// The tokens, with locations that are offsets from the start of the
+    /// file and strings that are owned by the cache.
+    std::vector<MMToken> Tokens;
+    llvm::BumpPtrAllocator Strings;
+
+    /// Makes a copy of \p Str the string of \p Tok.
+    void setString(MMToken &Tok, StringRef Str) {
+      char *Saved = Strings.Allocate<char>(Str.size() + 1);
+      memcpy(Saved, Str.data(), Str.size());
+      Saved[Str.size()] = 0;
+      Tok.StringData = Saved;
+      Tok.StringLength = Str.size();
+    }
+  };
+
+  std::mutex Mutex;
+  llvm::DenseMap<KeyTy, std::unique_ptr<CachedFile>> Files;
+
+  static std::string getPath(StringRef CacheDir, KeyTy Key);
+  static std::unique_ptr<CachedFile> read(StringRef Path, size_t FileSize);
+  static void write(StringRef Path, const CachedFile &File);
+
+  ArrayRef<MMToken> add(KeyTy Key, std::unique_ptr<CachedFile> File) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Files.try_emplace(Key, std::move(File)).first->second->Tokens;
+  }
+
+public:
+  /// Returns the cached tokens of a file of \p FileSize bytes, which stay
+  /// valid for the lifetime of the process, or no tokens. Files that are not
+  /// in memory are looked for in the module cache at \p CacheDir.
+  ArrayRef<MMToken> lookup(KeyTy Key, StringRef CacheDir, size_t FileSize) {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      auto Known = Files.find(Key);
+      if (Known != Files.end())
+        return Known->second->Tokens;
+    }
+    if (CacheDir.empty())
+      return None;
+    std::unique_ptr<CachedFile> File = read(getPath(CacheDir, Key), FileSize);
+    if (!File)
+      return None;
+    return add(Key, std::move(File));
+  }
+
+  void insert(KeyTy Key, ArrayRef<MMToken> Tokens, SourceLocation FileStart,
+              StringRef CacheDir) {
+    // Tokens are only cached once the parse reached the end of the file.
+    if (Tokens.empty() || !Tokens.back().is(MMToken::EndOfFile))
+      return;
+
+    auto File = llvm::make_unique<CachedFile>();
+    File->Tokens.assign(Tokens.begin(), Tokens.end());
+    for (MMToken &Tok : File->Tokens) {
+      Tok.Location = Tok.getLocation().getRawEncoding() -
+                     FileStart.getRawEncoding();
+      if (Tok.is(MMToken::IntegerLiteral) || !Tok.StringData)
+        continue;
+      File->setString(Tok, Tok.getString());
+    }
+
+    if (!CacheDir.empty())
+      write(getPath(CacheDir, Key), *File);
+    add(Key, std::move(File));
+  }
+};
+
+} // namespace
+
+/// The signature of the token files in the module cache.
+static const char TokenFileSignature[] = {'M', 'M', 'T', 'K'};
+
+/// Returns the path of the token file of a module map file. The compiler
+/// version is part of the name, so that compilers of different versions
+/// sharing a module cache do not read each other's files.
+std::string ModuleMapTokenCache::getPath(StringRef CacheDir, KeyTy Key) {
+  size_t VersionKey =
+      llvm::hash_combine(Key.second, getClangFullRepositoryVersion());
+  SmallString<128> Path(CacheDir);
+  llvm::sys::path::append(Path, "modulemap-tokens",
+                          llvm::utohexstr(Key.first) + "-" +
+                              llvm::utohexstr(VersionKey) + ".tokens");
+  return Path.str();
+}
+
+/// Reads a little-endian integer from the front of \p Data.
+template <typename T> static bool readInteger(StringRef &Data, T &Value) {
+  if (Data.size() < sizeof(T))
+    return false;
+  Value = llvm::support::endian::read<T, llvm::support::little,
+                                      llvm::support::unaligned>(Data.data());
+  Data = Data.drop_front(sizeof(T));
+  return true;
+}
+
+/// Reads a token file that \c write wrote. Files that are damaged, come from
+/// another compiler version or do not fit the module map file are ignored.
+std::unique_ptr<ModuleMapTokenCache::CachedFile>
+ModuleMapTokenCache::read(StringRef Path, size_t FileSize) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return nullptr;
+  StringRef Data = (*Buffer)->getBuffer();
+
+  StringRef Signature(TokenFileSignature, sizeof(TokenFileSignature));
+  if (!Data.consume_front(Signature))
+    return nullptr;
+  uint32_t VersionLength;
+  if (!readInteger(Data, VersionLength) || Data.size() < VersionLength ||
+      Data.substr(0, VersionLength) != getClangFullRepositoryVersion())
+    return nullptr;
+  Data = Data.drop_front(VersionLength);
+
+  uint32_t NumTokens;
+  if (!readInteger(Data, NumTokens) || NumTokens == 0)
+    return nullptr;
+  auto File = llvm::make_unique<CachedFile>();
+  File->Tokens.resize(NumTokens);
+  for (MMToken &Tok : File->Tokens) {
+    Tok.clear();
+    uint8_t Kind;
+    if (!readInteger(Data, Kind) || Kind > MMToken::RSquare ||
+        !readInteger(Data, Tok.Location) || Tok.Location > FileSize)
+      return nullptr;
+    Tok.Kind = static_cast<MMToken::TokenKind>(Kind);
+    if (Tok.is(MMToken::IntegerLiteral)) {
+      if (!readInteger(Data, Tok.IntegerValue))
+        return nullptr;
+      continue;
+    }
+    uint32_t Length;
+    if (!readInteger(Data, Length) || Data.size() < Length)
+      return nullptr;
+    if (Length)
+      File->setString(Tok, Data.substr(0, Length));
+    Data = Data.drop_front(Length);
+  }
+  if (!Data.empty() || !File->Tokens.back().is(MMToken::EndOfFile))
+    return nullptr;
+  return File;
+}
+
+/// Writes the tokens of a module map file to the module cache. The file is
+/// written under a unique name and then renamed, so that concurrent
+/// compilations never read it half-written.
+void ModuleMapTokenCache::write(StringRef Path, const CachedFile &File) {
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)))
+    return;
+  SmallString<128> TempPath(Path);
+  TempPath += "-%%%%%%%%";
+  int TempFD;
+  if (llvm::sys::fs::createUniqueFile(TempPath, TempFD, TempPath))
+    return;
+
+  llvm::raw_fd_ostream OS(TempFD, /*shouldClose=*/true);
+  llvm::support::endian::Writer Writer(OS, llvm::support::little);
+  OS.write(TokenFileSignature, sizeof(TokenFileSignature));
+  std::string Version = getClangFullRepositoryVersion();
+  Writer.write<uint32_t>(Version.size());
+  OS << Version;
+  Writer.write<uint32_t>(File.Tokens.size());
+  for (const MMToken &Tok : File.Tokens) {
+    Writer.write<uint8_t>(Tok.Kind);
+    Writer.write<uint32_t>(Tok.Location);
+    if (Tok.is(MMToken::IntegerLiteral)) {
+      Writer.write<uint64_t>(Tok.IntegerValue);
+      continue;
+    }
+    StringRef Str = Tok.StringData ? Tok.getString() : StringRef();
+    Writer.write<uint32_t>(Str.size());
+    OS << Str;
+  }
+  OS.close();
+
+  if (OS.has_error()) {
+    OS.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return;
+  }
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
+static llvm::ManagedStatic<ModuleMapTokenCache> TokenCache;
+
 SourceLocation ModuleMapParser::consumeToken() {
   SourceLocation Result = Tok.getLocation();
 
+  if (!CachedTokens.empty()) {
+    // The parser stops at the end of file token, so never runs out of cached
+    // tokens.
+    Tok = CachedTokens.front();
+    Tok.Location = FileStart.getLocWithOffset(Tok.Location).getRawEncoding();
+    if (CachedTokens.size() > 1)
+      CachedTokens = CachedTokens.drop_front();
+    return Result;
+  }
+
 retry:
   Tok.clear();
   Token LToken;
@@ -1561,12 +1803,17 @@ retry:
     if (LToken.hasUDSuffix()) {
       Diags.Report(LToken.getLocation(), diag::err_invalid_string_udl);
       HadError = true;
+      LexingDiagnosed = true;
       goto retry;
     }
 
     // Parse the string literal.
     LangOptions LangOpts;
     StringLiteralParser StringLiteral(LToken, SourceMgr, LangOpts, *Target);
+    // Escape sequences can be diagnosed without making the literal invalid.
+    if (StringLiteral.hadError ||
+        StringRef(LToken.getLiteralData(), LToken.getLength()).contains('\\'))
+      LexingDiagnosed = true;
     if (StringLiteral.hadError)
       goto retry;
 
@@ -1594,6 +1841,7 @@ retry:
     if (StringRef(Start, Length).getAsInteger(0, Value)) {
       Diags.Report(Tok.getLocation(), diag::err_mmap_unknown_token);
       HadError = true;
+      LexingDiagnosed = true;
       goto retry;
     }
 
@@ -1627,9 +1875,12 @@ retry:
   default:
     Diags.Report(Tok.getLocation(), diag::err_mmap_unknown_token);
     HadError = true;
+    LexingDiagnosed = true;
     goto retry;
   }
 
+  if (LexedTokens)
+    LexedTokens->push_back(Tok);
   return Result;
 }
 
@@ -3002,6 +3253,19 @@ bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem,
   assert((!Offset || *Offset <= Buffer->getBufferSize()) &&
          "invalid buffer offset");
 
+  // Files parsed from the start can reuse the tokens of an earlier parse of
+  // the same contents, and otherwise provide them for later parses.
+  ModuleMapTokenCache::KeyTy CacheKey;
+  ArrayRef<MMToken> CachedTokens;
+  SmallVector<MMToken, 0> LexedTokens;
+  if (!Offset) {
+    CacheKey = {llvm::xxHash64(Buffer->getBuffer()),
+                llvm::hash_combine(Buffer->getBufferSize(),
+                                   Target->getCharWidth())};
+    CachedTokens = TokenCache->lookup(CacheKey, HeaderInfo.getModuleCachePath(),
+                                      Buffer->getBufferSize());
+  }
+
   // Parse this module map file.
   Lexer L(SourceMgr.getLocForStartOfFile(ID), MMapLangOpts,
           Buffer->getBufferStart(),
@@ -3009,10 +3273,19 @@ bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem,
           Buffer->getBufferEnd());
   SourceLocation Start = L.getSourceLocation();
   ModuleMapParser Parser(L, SourceMgr, Target, Diags, *this, File, Dir,
-                         IsSystem);
+                         IsSystem, CachedTokens,
+                         Offset || !CachedTokens.empty() ? nullptr
+                                                         : &LexedTokens);
   bool Result = Parser.parseModuleMapFile();
   ParsedModuleMap[File] = Result;
 
+  ++NumModuleMapFilesParsed;
+  if (!CachedTokens.empty())
+    ++NumModuleMapFilesReplayed;
+  else if (!Offset && !Parser.lexingDiagnosed())
+    TokenCache->insert(CacheKey, LexedTokens, Start,
+                       HeaderInfo.getModuleCachePath());
+
   if (Offset) {
     auto Loc = SourceMgr.getDecomposedLoc(Parser.getLocation());
     assert(Loc.first == ID && "stopped in a different file?");
@@ -33,6 +33,7 @@
 #include "clang/Lex/Token.h"
 #include "clang/Lex/VariadicMacroSupport.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/STLExtras.h"
@@ -41,6 +42,7 @@
 #include "llvm/Support/AlignOf.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -369,27 +371,61 @@ SourceLocation Preprocessor::CheckEndOfDirective(const char *DirType,
   return DiscardUntilEndOfDirective().getEnd();
 }
 
+SharedSkippedRangeCache::FileRanges *
+Preprocessor::getSharedSkippedRanges(FileID FID) {
+  // The dependency scanner provides its own mappings, and code completion
+  // must not skip over the completion point.
+  if (ExcludedConditionalDirectiveSkipMappings || isCodeCompletionEnabled())
+    return nullptr;
+
+  const llvm::MemoryBuffer *Buf = SourceMgr.getBuffer(FID);
+  SharedSkippedRangeCache::FileRanges *&Ranges = SharedSkippedRanges[Buf];
+  if (!Ranges) {
+    // Where a block ends depends on how comments, strings and line
+    // continuations are lexed, so that is part of the key too.
+    uint64_t LexingOptions = llvm::hash_combine(
+        Buf->getBufferSize(), LangOpts.Trigraphs, LangOpts.LineComment,
+        LangOpts.Digraphs, LangOpts.CPlusPlus, LangOpts.CPlusPlus11,
+        LangOpts.CPlusPlus14, LangOpts.ObjC, LangOpts.MicrosoftExt,
+        LangOpts.AsmPreprocessor);
+    Ranges = &SharedSkippedRangeCache::getFileRanges(
+        {llvm::xxHash64(Buf->getBuffer()), LexingOptions});
+  }
+  return Ranges;
+}
+
 Optional<unsigned> Preprocessor::getSkippedRangeForExcludedConditionalBlock(
     SourceLocation HashLoc) {
-  if (!ExcludedConditionalDirectiveSkipMappings)
-    return None;
   if (!HashLoc.isFileID())
     return None;
 
   std::pair<FileID, unsigned> HashFileOffset =
       SourceMgr.getDecomposedLoc(HashLoc);
-  const llvm::MemoryBuffer *Buf = SourceMgr.getBuffer(HashFileOffset.first);
-  auto It = ExcludedConditionalDirectiveSkipMappings->find(Buf);
-  if (It == ExcludedConditionalDirectiveSkipMappings->end())
-    return None;
-
-  const PreprocessorSkippedRangeMapping &SkippedRanges = *It->getSecond();
-  // Check if the offset of '#' is mapped in the skipped ranges.
-  auto MappingIt = SkippedRanges.find(HashFileOffset.second);
-  if (MappingIt == SkippedRanges.end())
+  unsigned BytesToSkip;
+  if (ExcludedConditionalDirectiveSkipMappings) {
+    const llvm::MemoryBuffer *Buf = SourceMgr.getBuffer(HashFileOffset.first);
+    auto It = ExcludedConditionalDirectiveSkipMappings->find(Buf);
+    if (It == ExcludedConditionalDirectiveSkipMappings->end())
+      return None;
+
+    const PreprocessorSkippedRangeMapping &SkippedRanges = *It->getSecond();
+    // Check if the offset of '#' is mapped in the skipped ranges.
+    auto MappingIt = SkippedRanges.find(HashFileOffset.second);
+    if (MappingIt == SkippedRanges.end())
+      return None;
+
+    BytesToSkip = MappingIt->getSecond();
+  } else if (SharedSkippedRangeCache::FileRanges *SharedRanges =
+                 getSharedSkippedRanges(HashFileOffset.first)) {
+    // Check if an earlier skip of this block found where it ends.
+    BytesToSkip = SharedRanges->lookup(HashFileOffset.second);
+    if (!BytesToSkip)
+      return None;
+    ++NumSkippedWithoutLexing;
+  } else {
     return None;
+  }
 
-  unsigned BytesToSkip = MappingIt->getSecond();
   unsigned CurLexerBufferOffset = CurLexer->getCurrentBufferOffset();
   assert(CurLexerBufferOffset >= HashFileOffset.second &&
          "lexer is before the hash?");
@@ -416,20 +452,43 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
   ++NumSkipped;
   assert(!CurTokenLexer && CurPPLexer && "Lexing a macro, not a file?");
 
-  if (PreambleConditionalStack.reachedEOFWhileSkipping())
+  // When resuming to skip a block that the preamble ended in, the lexer is not
+  // at the directive that started skipping.
+  bool ResumingSkip = PreambleConditionalStack.reachedEOFWhileSkipping();
+  if (ResumingSkip)
     PreambleConditionalStack.clearSkipInfo();
   else
     CurPPLexer->pushConditionalLevel(IfTokenLoc, /*isSkipping*/ false,
                                      FoundNonSkipPortion, FoundElse);
 
+  // Record where the blocks of this conditional end, so that this and other
+  // compilations in the process can skip over them without lexing them.
+  SharedSkippedRangeCache::FileRanges *SharedRanges = nullptr;
+  unsigned BlockStart = 0;
+  if (!ResumingSkip && CurLexer && HashTokenLoc.isFileID()) {
+    std::pair<FileID, unsigned> HashFileOffset =
+        SourceMgr.getDecomposedLoc(HashTokenLoc);
+    SharedRanges = getSharedSkippedRanges(HashFileOffset.first);
+    BlockStart = HashFileOffset.second;
+  }
+  auto RecordEndOfBlock = [&](SourceLocation NextHashLoc) {
+    if (!SharedRanges)
+      return;
+    unsigned BlockEnd = SourceMgr.getFileOffset(NextHashLoc);
+    SharedRanges->add(BlockStart, BlockEnd - BlockStart);
+    BlockStart = BlockEnd;
+  };
+
   // Enter raw mode to disable identifier lookup (and thus macro expansion),
   // disabling warnings, etc.
   CurPPLexer->LexingRawMode = true;
   Token Tok;
-  if (auto SkipLength =
-          getSkippedRangeForExcludedConditionalBlock(HashTokenLoc)) {
-    // Skip to the next '#endif' / '#else' / '#elif'.
-    CurLexer->skipOver(*SkipLength);
+  if (!ResumingSkip) {
+    if (auto SkipLength =
+            getSkippedRangeForExcludedConditionalBlock(HashTokenLoc)) {
+      // Skip to the next '#endif' / '#else' / '#elif'.
+      CurLexer->skipOver(*SkipLength);
+    }
   }
   while (true) {
     CurLexer->Lex(Tok);
@@ -455,6 +514,8 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
     // If this token is not a preprocessor directive, just skip it.
     if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
       continue;
+    SourceLocation DirectiveHashLoc = Tok.getLocation();
+    bool AtNextBlock = false;
 
     // We just parsed a # character at the start of a line, so we're in
     // directive mode.  Tell the lexer this so any newlines we see will be
@@ -534,6 +595,7 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
 
         // If we popped the outermost skipping block, we're done skipping!
         if (!CondInfo.WasSkipping) {
+          RecordEndOfBlock(DirectiveHashLoc);
           // Restore the value of LexingRawMode so that trailing comments
           // are handled correctly, if we've reached the outermost block.
           CurPPLexer->LexingRawMode = false;
@@ -550,9 +612,18 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
         // skipping conditional, and if #else hasn't already been seen, enter it
         // as a non-skipping conditional.
         PPConditionalInfo &CondInfo = CurPPLexer->peekConditionalLevel();
+        if (!CondInfo.WasSkipping) {
+          RecordEndOfBlock(DirectiveHashLoc);
+          AtNextBlock = true;
+        }
 
         // If this is a #else with a #else before it, report the error.
-        if (CondInfo.FoundElse) Diag(Tok, diag::pp_err_else_after_else);
+        if (CondInfo.FoundElse) {
+          Diag(Tok, diag::pp_err_else_after_else);
+          // Skipping over this directive would lose the error.
+          if (CondInfo.WasSkipping)
+            SharedRanges = nullptr;
+        }
 
         // Note that we've seen a #else in this conditional.
         CondInfo.FoundElse = true;
@@ -574,9 +645,18 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
         }
       } else if (Sub == "lif") {  // "elif".
         PPConditionalInfo &CondInfo = CurPPLexer->peekConditionalLevel();
+        if (!CondInfo.WasSkipping) {
+          RecordEndOfBlock(DirectiveHashLoc);
+          AtNextBlock = true;
+        }
 
         // If this is a #elif with a #else before it, report the error.
-        if (CondInfo.FoundElse) Diag(Tok, diag::pp_err_elif_after_else);
+        if (CondInfo.FoundElse) {
+          Diag(Tok, diag::pp_err_elif_after_else);
+          // Skipping over this directive would lose the error.
+          if (CondInfo.WasSkipping)
+            SharedRanges = nullptr;
+        }
 
         // If this is in a skipping block or if we're already handled this #if
         // block, don't bother parsing the condition.
@@ -609,6 +689,14 @@ void Preprocessor::SkipExcludedConditionalBlock(SourceLocation HashTokenLoc,
     CurPPLexer->ParsingPreprocessorDirective = false;
     // Restore comment saving mode.
     if (CurLexer) CurLexer->resetExtendedTokenMode();
+
+    // The next block of this conditional is skipped too; skip over it if an
+    // earlier skip found where it ends.
+    if (AtNextBlock && SharedRanges) {
+      if (auto SkipLength =
+              getSkippedRangeForExcludedConditionalBlock(DirectiveHashLoc))
+        CurLexer->skipOver(*SkipLength);
+    }
   }
 
   // Finally, if we are out of the conditional (saw an #endif or ran off the end
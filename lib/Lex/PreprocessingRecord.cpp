@@ -127,8 +127,8 @@ bool PreprocessingRecord::isEntityInFileID(iterator PPEI, FileID FID) {
     assert(0 && "Out-of bounds local preprocessed entity");
     return false;
   }
-  return isPreprocessedEntityIfInFileID(PreprocessedEntities[Pos],
-                                        FID, SourceMgr);
+  SourceLocation Loc = PreprocessedEntityRanges[Pos].getBegin();
+  return Loc.isValid() && SourceMgr.isInFileID(SourceMgr.getFileLoc(Loc), FID);
 }
 
 /// Returns a pair of [Begin, End) iterators of preprocessed entities
@@ -183,25 +183,16 @@ struct PPEntityComp {
 
   explicit PPEntityComp(const SourceManager &SM) : SM(SM) {}
 
-  bool operator()(PreprocessedEntity *L, PreprocessedEntity *R) const {
-    SourceLocation LHS = getLoc(L);
-    SourceLocation RHS = getLoc(R);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
+  bool operator()(const SourceRange &L, const SourceRange &R) const {
+    return SM.isBeforeInTranslationUnit((L.*getRangeLoc)(), (R.*getRangeLoc)());
   }
 
-  bool operator()(PreprocessedEntity *L, SourceLocation RHS) const {
-    SourceLocation LHS = getLoc(L);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
+  bool operator()(const SourceRange &L, SourceLocation RHS) const {
+    return SM.isBeforeInTranslationUnit((L.*getRangeLoc)(), RHS);
   }
 
-  bool operator()(SourceLocation LHS, PreprocessedEntity *R) const {
-    SourceLocation RHS = getLoc(R);
-    return SM.isBeforeInTranslationUnit(LHS, RHS);
-  }
-
-  SourceLocation getLoc(PreprocessedEntity *PPE) const {
-    SourceRange Range = PPE->getSourceRange();
-    return (Range.*getRangeLoc)();
+  bool operator()(SourceLocation LHS, const SourceRange &R) const {
+    return SM.isBeforeInTranslationUnit(LHS, (R.*getRangeLoc)());
   }
 };
 
@@ -212,11 +203,11 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
   if (SourceMgr.isLoadedSourceLocation(Loc))
     return 0;
 
-  size_t Count = PreprocessedEntities.size();
+  size_t Count = PreprocessedEntityRanges.size();
   size_t Half;
-  std::vector<PreprocessedEntity *>::const_iterator
-    First = PreprocessedEntities.begin();
-  std::vector<PreprocessedEntity *>::const_iterator I;
+  std::vector<SourceRange>::const_iterator
+    First = PreprocessedEntityRanges.begin();
+  std::vector<SourceRange>::const_iterator I;
 
   // Do a binary search manually instead of using std::lower_bound because
   // The end locations of entities may be unordered (when a macro expansion
@@ -226,8 +217,7 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
     Half = Count/2;
     I = First;
     std::advance(I, Half);
-    if (SourceMgr.isBeforeInTranslationUnit((*I)->getSourceRange().getEnd(),
-                                            Loc)){
+    if (SourceMgr.isBeforeInTranslationUnit(I->getEnd(), Loc)) {
       First = I;
       ++First;
       Count = Count - Half - 1;
@@ -235,7 +225,7 @@ unsigned PreprocessingRecord::findBeginLocalPreprocessedEntity(
       Count = Half;
   }
 
-  return First - PreprocessedEntities.begin();
+  return First - PreprocessedEntityRanges.begin();
 }
 
 unsigned PreprocessingRecord::findEndLocalPreprocessedEntity(
@@ -243,34 +233,36 @@ unsigned PreprocessingRecord::findEndLocalPreprocessedEntity(
   if (SourceMgr.isLoadedSourceLocation(Loc))
     return 0;
 
-  std::vector<PreprocessedEntity *>::const_iterator
-  I = std::upper_bound(PreprocessedEntities.begin(),
-                       PreprocessedEntities.end(),
+  std::vector<SourceRange>::const_iterator
+  I = std::upper_bound(PreprocessedEntityRanges.begin(),
+                       PreprocessedEntityRanges.end(),
                        Loc,
                        PPEntityComp<&SourceRange::getBegin>(SourceMgr));
-  return I - PreprocessedEntities.begin();
+  return I - PreprocessedEntityRanges.begin();
 }
 
 PreprocessingRecord::PPEntityID
 PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   assert(Entity);
-  SourceLocation BeginLoc = Entity->getSourceRange().getBegin();
+  SourceRange Range = Entity->getSourceRange();
+  SourceLocation BeginLoc = Range.getBegin();
 
   if (isa<MacroDefinitionRecord>(Entity)) {
-    assert((PreprocessedEntities.empty() ||
+    assert((PreprocessedEntityRanges.empty() ||
             !SourceMgr.isBeforeInTranslationUnit(
-                BeginLoc,
-                PreprocessedEntities.back()->getSourceRange().getBegin())) &&
+                BeginLoc, PreprocessedEntityRanges.back().getBegin())) &&
            "a macro definition was encountered out-of-order");
     PreprocessedEntities.push_back(Entity);
+    PreprocessedEntityRanges.push_back(Range);
     return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
   }
 
   // Check normal case, this entity begin location is after the previous one.
-  if (PreprocessedEntities.empty() ||
-      !SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                   PreprocessedEntities.back()->getSourceRange().getBegin())) {
+  if (PreprocessedEntityRanges.empty() ||
+      !SourceMgr.isBeforeInTranslationUnit(
+          BeginLoc, PreprocessedEntityRanges.back().getBegin())) {
     PreprocessedEntities.push_back(Entity);
+    PreprocessedEntityRanges.push_back(Range);
     return getPPEntityID(PreprocessedEntities.size()-1, /*isLoaded=*/false);
   }
 
@@ -286,32 +278,29 @@ PreprocessingRecord::addPreprocessedEntity(PreprocessedEntity *Entity) {
   //  FM(M1, M2)
   // \endcode
 
-  using pp_iter = std::vector<PreprocessedEntity *>::iterator;
+  auto InsertAt = [&](size_t Index) {
+    PreprocessedEntities.insert(PreprocessedEntities.begin() + Index, Entity);
+    PreprocessedEntityRanges.insert(PreprocessedEntityRanges.begin() + Index,
+                                    Range);
+    return getPPEntityID(Index, /*isLoaded=*/false);
+  };
 
   // Usually there are few macro expansions when defining the filename, do a
   // linear search for a few entities.
   unsigned count = 0;
-  for (pp_iter RI    = PreprocessedEntities.end(),
-               Begin = PreprocessedEntities.begin();
-       RI != Begin && count < 4; --RI, ++count) {
-    pp_iter I = RI;
-    --I;
-    if (!SourceMgr.isBeforeInTranslationUnit(BeginLoc,
-                                           (*I)->getSourceRange().getBegin())) {
-      pp_iter insertI = PreprocessedEntities.insert(RI, Entity);
-      return getPPEntityID(insertI - PreprocessedEntities.begin(),
-                           /*isLoaded=*/false);
-    }
+  for (size_t RI = PreprocessedEntityRanges.size(); RI != 0 && count < 4;
+       --RI, ++count) {
+    if (!SourceMgr.isBeforeInTranslationUnit(
+            BeginLoc, PreprocessedEntityRanges[RI - 1].getBegin()))
+      return InsertAt(RI);
   }
 
   // Linear search unsuccessful. Do a binary search.
-  pp_iter I = std::upper_bound(PreprocessedEntities.begin(),
-                               PreprocessedEntities.end(),
-                               BeginLoc,
-                               PPEntityComp<&SourceRange::getBegin>(SourceMgr));
-  pp_iter insertI = PreprocessedEntities.insert(I, Entity);
-  return getPPEntityID(insertI - PreprocessedEntities.begin(),
-                       /*isLoaded=*/false);
+  auto I = std::upper_bound(PreprocessedEntityRanges.begin(),
+                            PreprocessedEntityRanges.end(),
+                            BeginLoc,
+                            PPEntityComp<&SourceRange::getBegin>(SourceMgr));
+  return InsertAt(I - PreprocessedEntityRanges.begin());
 }
 
 void PreprocessingRecord::SetExternalSource(
@@ -497,5 +486,6 @@ size_t PreprocessingRecord::getTotalMemory() const {
   return BumpAlloc.getTotalMemory()
     + llvm::capacity_in_bytes(MacroDefinitions)
     + llvm::capacity_in_bytes(PreprocessedEntities)
+    + llvm::capacity_in_bytes(PreprocessedEntityRanges)
     + llvm::capacity_in_bytes(LoadedPreprocessedEntities);
 }
@@ -276,14 +276,16 @@ void Preprocessor::PrintStats() {
   llvm::errs() << "  " << NumElse << " #else/#elif.\n";
   llvm::errs() << "  " << NumEndif << " #endif.\n";
   llvm::errs() << "  " << NumPragma << " #pragma.\n";
-  llvm::errs() << NumSkipped << " #if/#ifndef#ifdef regions skipped\n";
+  llvm::errs() << NumSkipped << " #if/#ifndef#ifdef regions skipped, "
+               << NumSkippedWithoutLexing << " blocks skipped without lexing.\n";
 
   llvm::errs() << NumMacroExpanded << "/" << NumFnMacroExpanded << "/"
              << NumBuiltinMacroExpanded << " obj/fn/builtin macros expanded, "
              << NumFastMacroExpanded << " on the fast path.\n";
   llvm::errs() << (NumFastTokenPaste+NumTokenPaste)
              << " token paste (##) operations performed, "
-             << NumFastTokenPaste << " on the fast path.\n";
+             << NumFastTokenPaste << " on the fast path, "
+             << NumCachedTokenPaste << " reusing an earlier result.\n";
 
   llvm::errs() << "\nPreprocessor Memory: " << getTotalMemory() << "B total";
 
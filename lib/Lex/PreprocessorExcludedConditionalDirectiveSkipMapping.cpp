@@ -0,0 +1,51 @@
+//===--- PreprocessorExcludedConditionalDirectiveSkipMapping.cpp ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the process-wide cache of the ranges that the
+// preprocessor skips in excluded conditional blocks.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/PreprocessorExcludedConditionalDirectiveSkipMapping.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <memory>
+
+using namespace clang;
+
+namespace {
+
+struct SharedSkippedRanges {
+  std::mutex Lock;
+  llvm::DenseMap<SharedSkippedRangeCache::KeyTy,
+                 std::unique_ptr<SharedSkippedRangeCache::FileRanges>>
+      Files;
+};
+
+} // end anonymous namespace
+
+static llvm::ManagedStatic<SharedSkippedRanges> SkippedRanges;
+
+unsigned SharedSkippedRangeCache::FileRanges::lookup(unsigned Offset) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return Ranges.lookup(Offset);
+}
+
+void SharedSkippedRangeCache::FileRanges::add(unsigned Offset,
+                                              unsigned Length) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  Ranges[Offset] = Length;
+}
+
+SharedSkippedRangeCache::FileRanges &
+SharedSkippedRangeCache::getFileRanges(KeyTy Key) {
+  std::lock_guard<std::mutex> Guard(SkippedRanges->Lock);
+  std::unique_ptr<FileRanges> &Ranges = SkippedRanges->Files[Key];
+  if (!Ranges)
+    Ranges = llvm::make_unique<FileRanges>();
+  return *Ranges;
+}
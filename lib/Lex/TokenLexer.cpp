@@ -797,96 +797,105 @@ bool TokenLexer::pasteTokens(Token &LHSTok, ArrayRef<Token> TokenStream,
     // Trim excess space.
     Buffer.resize(LHSLen+RHSLen);
 
-    // Plop the pasted result (including the trailing newline and null) into a
-    // scratch buffer where we can lex it.
-    Token ResultTokTmp;
-    ResultTokTmp.startToken();
-
-    // Claim that the tmp token is a string_literal so that we can get the
-    // character pointer back from CreateString in getLiteralData().
-    ResultTokTmp.setKind(tok::string_literal);
-    PP.CreateString(Buffer, ResultTokTmp);
-    SourceLocation ResultTokLoc = ResultTokTmp.getLocation();
-    ResultTokStrPtr = ResultTokTmp.getLiteralData();
-
-    // Lex the resultant pasted token into Result.
-    Token Result;
+    bool IsFastPaste = LHSTok.isAnyIdentifier() && RHS.isAnyIdentifier();
+    PP.IncrementPasteCounter(IsFastPaste);
 
-    if (LHSTok.isAnyIdentifier() && RHS.isAnyIdentifier()) {
-      // Common paste case: identifier+identifier = identifier.  Avoid creating
-      // a lexer and other overhead.
-      PP.IncrementPasteCounter(true);
-      Result.startToken();
-      Result.setKind(tok::raw_identifier);
-      Result.setRawIdentifierData(ResultTokStrPtr);
-      Result.setLocation(ResultTokLoc);
-      Result.setLength(LHSLen+RHSLen);
+    // Pasting the same spellings always forms the same token, so reuse the
+    // scratch buffer copy and the lexed result of an earlier paste if there
+    // was one.
+    Token Result;
+    if (const Token *Cached = PP.getCachedPasteResult(Buffer)) {
+      Result = *Cached;
     } else {
-      PP.IncrementPasteCounter(false);
-
-      assert(ResultTokLoc.isFileID() &&
-             "Should be a raw location into scratch buffer");
-      SourceManager &SourceMgr = PP.getSourceManager();
-      FileID LocFileID = SourceMgr.getFileID(ResultTokLoc);
-
-      bool Invalid = false;
-      const char *ScratchBufStart
-        = SourceMgr.getBufferData(LocFileID, &Invalid).data();
-      if (Invalid)
-        return false;
-
-      // Make a lexer to lex this string from.  Lex just this one token.
-      // Make a lexer object so that we lex and expand the paste result.
-      Lexer TL(SourceMgr.getLocForStartOfFile(LocFileID),
-               PP.getLangOpts(), ScratchBufStart,
-               ResultTokStrPtr, ResultTokStrPtr+LHSLen+RHSLen);
-
-      // Lex a token in raw mode.  This way it won't look up identifiers
-      // automatically, lexing off the end will return an eof token, and
-      // warnings are disabled.  This returns true if the result token is the
-      // entire buffer.
-      bool isInvalid = !TL.LexFromRawLexer(Result);
-
-      // If we got an EOF token, we didn't form even ONE token.  For example, we
-      // did "/ ## /" to get "//".
-      isInvalid |= Result.is(tok::eof);
-
-      // If pasting the two tokens didn't form a full new token, this is an
-      // error.  This occurs with "x ## +"  and other stuff.  Return with LHSTok
-      // unmodified and with RHS as the next token to lex.
-      if (isInvalid) {
-        // Explicitly convert the token location to have proper expansion
-        // information so that the user knows where it came from.
-        SourceManager &SM = PP.getSourceManager();
-        SourceLocation Loc =
-          SM.createExpansionLoc(PasteOpLoc, ExpandLocStart, ExpandLocEnd, 2);
-
-        // Test for the Microsoft extension of /##/ turning into // here on the
-        // error path.
-        if (PP.getLangOpts().MicrosoftExt && LHSTok.is(tok::slash) &&
-            RHS.is(tok::slash)) {
-          HandleMicrosoftCommentPaste(LHSTok, Loc);
-          return true;
-        }
+      // Plop the pasted result (including the trailing newline and null) into
+      // a scratch buffer where we can lex it.
+      Token ResultTokTmp;
+      ResultTokTmp.startToken();
+
+      // Claim that the tmp token is a string_literal so that we can get the
+      // character pointer back from CreateString in getLiteralData().
+      ResultTokTmp.setKind(tok::string_literal);
+      PP.CreateString(Buffer, ResultTokTmp);
+      SourceLocation ResultTokLoc = ResultTokTmp.getLocation();
+      ResultTokStrPtr = ResultTokTmp.getLiteralData();
+
+      // Lex the resultant pasted token into Result.
+      if (IsFastPaste) {
+        // Common paste case: identifier+identifier = identifier.  Avoid
+        // creating a lexer and other overhead.
+        Result.startToken();
+        Result.setKind(tok::raw_identifier);
+        Result.setRawIdentifierData(ResultTokStrPtr);
+        Result.setLocation(ResultTokLoc);
+        Result.setLength(LHSLen+RHSLen);
+      } else {
+        assert(ResultTokLoc.isFileID() &&
+               "Should be a raw location into scratch buffer");
+        SourceManager &SourceMgr = PP.getSourceManager();
+        FileID LocFileID = SourceMgr.getFileID(ResultTokLoc);
+
+        bool Invalid = false;
+        const char *ScratchBufStart
+          = SourceMgr.getBufferData(LocFileID, &Invalid).data();
+        if (Invalid)
+          return false;
+
+        // Make a lexer to lex this string from.  Lex just this one token.
+        // Make a lexer object so that we lex and expand the paste result.
+        Lexer TL(SourceMgr.getLocForStartOfFile(LocFileID),
+                 PP.getLangOpts(), ScratchBufStart,
+                 ResultTokStrPtr, ResultTokStrPtr+LHSLen+RHSLen);
+
+        // Lex a token in raw mode.  This way it won't look up identifiers
+        // automatically, lexing off the end will return an eof token, and
+        // warnings are disabled.  This returns true if the result token is the
+        // entire buffer.
+        bool isInvalid = !TL.LexFromRawLexer(Result);
+
+        // If we got an EOF token, we didn't form even ONE token.  For example,
+        // we did "/ ## /" to get "//".
+        isInvalid |= Result.is(tok::eof);
+
+        // If pasting the two tokens didn't form a full new token, this is an
+        // error.  This occurs with "x ## +"  and other stuff.  Return with
+        // LHSTok unmodified and with RHS as the next token to lex.
+        if (isInvalid) {
+          // Explicitly convert the token location to have proper expansion
+          // information so that the user knows where it came from.
+          SourceManager &SM = PP.getSourceManager();
+          SourceLocation Loc =
+            SM.createExpansionLoc(PasteOpLoc, ExpandLocStart, ExpandLocEnd, 2);
+
+          // Test for the Microsoft extension of /##/ turning into // here on
+          // the error path.
+          if (PP.getLangOpts().MicrosoftExt && LHSTok.is(tok::slash) &&
+              RHS.is(tok::slash)) {
+            HandleMicrosoftCommentPaste(LHSTok, Loc);
+            return true;
+          }
+
+          // Do not emit the error when preprocessing assembler code.
+          if (!PP.getLangOpts().AsmPreprocessor) {
+            // If we're in microsoft extensions mode, downgrade this from a hard
+            // error to an extension that defaults to an error.  This allows
+            // disabling it.
+            PP.Diag(Loc, PP.getLangOpts().MicrosoftExt
+                             ? diag::ext_pp_bad_paste_ms
+                             : diag::err_pp_bad_paste)
+                << Buffer;
+          }
 
-        // Do not emit the error when preprocessing assembler code.
-        if (!PP.getLangOpts().AsmPreprocessor) {
-          // If we're in microsoft extensions mode, downgrade this from a hard
-          // error to an extension that defaults to an error.  This allows
-          // disabling it.
-          PP.Diag(Loc, PP.getLangOpts().MicrosoftExt ? diag::ext_pp_bad_paste_ms
-                                                     : diag::err_pp_bad_paste)
-              << Buffer;
+          // An error has occurred so exit loop.
+          break;
         }
 
-        // An error has occurred so exit loop.
-        break;
+        // Turn ## into 'unknown' to avoid # ## # from looking like a paste
+        // operator.
+        if (Result.is(tok::hashhash))
+          Result.setKind(tok::unknown);
       }
 
-      // Turn ## into 'unknown' to avoid # ## # from looking like a paste
-      // operator.
-      if (Result.is(tok::hashhash))
-        Result.setKind(tok::unknown);
+      PP.cachePasteResult(Buffer, Result);
     }
 
     // Transfer properties of the LHS over the Result.
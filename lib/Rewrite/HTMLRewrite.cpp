@@ -17,12 +17,19 @@
 #include "clang/Lex/TokenConcatenation.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <memory>
 using namespace clang;
 
+#define DEBUG_TYPE "HTMLRewrite"
+
+STATISTIC(NumHighlightCacheHits,
+          "The # of file highlightings reused from an earlier rewrite");
+STATISTIC(NumHighlightCacheMisses,
+          "The # of file highlightings computed by lexing the file");
 
 /// HighlightRange - Highlight a range in the source code with the specified
 /// start/end tags.  B/E must be in the same file.  This ensures that
@@ -437,17 +444,56 @@ input.spoilerhider:checked + label + .spoiler{
   R.InsertTextAfter(EndLoc, "</body></html>\n");
 }
 
+/// Returns the list that the highlights of \p FID are recorded in, if they are
+/// to be recorded, and inserts them into \p RB if they were recorded before.
+static html::HighlightCache::HighlightList *
+lookupHighlights(std::map<FileID, html::HighlightCache::HighlightList> *Cache,
+                 FileID FID, RewriteBuffer &RB, const char *BufferStart,
+                 bool &Found) {
+  Found = false;
+  if (!Cache)
+    return nullptr;
+
+  auto Known = Cache->find(FID);
+  if (Known == Cache->end()) {
+    ++NumHighlightCacheMisses;
+    return &(*Cache)[FID];
+  }
+
+  ++NumHighlightCacheHits;
+  for (const html::HighlightCache::Highlight &H : Known->second)
+    html::HighlightRange(RB, H.B, H.E, BufferStart, H.StartTag.c_str(),
+                         H.EndTag.c_str());
+  Found = true;
+  return nullptr;
+}
+
 /// SyntaxHighlight - Relex the specified FileID and annotate the HTML with
 /// information about keywords, macro expansions etc.  This uses the macro
 /// table state from the end of the file, so it won't be perfectly perfect,
 /// but it will be reasonably close.
-void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
+void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP,
+                           HighlightCache *Cache) {
   RewriteBuffer &RB = R.getEditBuffer(FID);
 
   const SourceManager &SM = PP.getSourceManager();
   const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
+  const char *BufferStart = FromFile->getBufferStart();
+
+  bool Found;
+  HighlightCache::HighlightList *Highlights = lookupHighlights(
+      Cache ? &Cache->SyntaxHighlights : nullptr, FID, RB, BufferStart, Found);
+  if (Found)
+    return;
+
+  auto AddHighlight = [&](unsigned B, unsigned E, const char *StartTag,
+                          const char *EndTag) {
+    HighlightRange(RB, B, E, BufferStart, StartTag, EndTag);
+    if (Highlights)
+      Highlights->push_back({B, E, StartTag, EndTag});
+  };
+
   Lexer L(FID, FromFile, SM, PP.getLangOpts());
-  const char *BufferStart = L.getBuffer().data();
 
   // Inform the preprocessor that we want to retain comments as tokens, so we
   // can highlight them.
@@ -474,13 +520,13 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
 
       // If this is a pp-identifier, for a keyword, highlight it as such.
       if (Tok.isNot(tok::identifier))
-        HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                       "<span class='keyword'>", "</span>");
+        AddHighlight(TokOffs, TokOffs+TokLen,
+                     "<span class='keyword'>", "</span>");
       break;
     }
     case tok::comment:
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='comment'>", "</span>");
+      AddHighlight(TokOffs, TokOffs+TokLen,
+                   "<span class='comment'>", "</span>");
       break;
     case tok::utf8_string_literal:
       // Chop off the u part of u8 prefix
@@ -497,8 +543,8 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       LLVM_FALLTHROUGH;
     case tok::string_literal:
       // FIXME: Exclude the optional ud-suffix from the highlighted range.
-      HighlightRange(RB, TokOffs, TokOffs+TokLen, BufferStart,
-                     "<span class='string_literal'>", "</span>");
+      AddHighlight(TokOffs, TokOffs+TokLen,
+                   "<span class='string_literal'>", "</span>");
       break;
     case tok::hash: {
       // If this is a preprocessor directive, all tokens to end of line are too.
@@ -515,8 +561,8 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
       }
 
       // Find end of line.  This is a hack.
-      HighlightRange(RB, TokOffs, TokEnd, BufferStart,
-                     "<span class='directive'>", "</span>");
+      AddHighlight(TokOffs, TokEnd,
+                   "<span class='directive'>", "</span>");
 
       // Don't skip the next token.
       continue;
@@ -531,12 +577,23 @@ void html::SyntaxHighlight(Rewriter &R, FileID FID, const Preprocessor &PP) {
 /// file, to re-expand macros and insert (into the HTML) information about the
 /// macro expansions.  This won't be perfectly perfect, but it will be
 /// reasonably close.
-void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
+void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP,
+                           HighlightCache *Cache) {
+  RewriteBuffer &RB = R.getEditBuffer(FID);
+
   // Re-lex the raw token stream into a token buffer.
   const SourceManager &SM = PP.getSourceManager();
   std::vector<Token> TokenStream;
 
   const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
+  const char *BufferStart = FromFile->getBufferStart();
+
+  bool Found;
+  HighlightCache::HighlightList *Highlights = lookupHighlights(
+      Cache ? &Cache->MacroHighlights : nullptr, FID, RB, BufferStart, Found);
+  if (Found)
+    return;
+
   Lexer L(FID, FromFile, SM, PP.getLangOpts());
 
   // Lex all the tokens in raw mode, to avoid entering #includes or expanding
@@ -658,8 +715,15 @@ void html::HighlightMacros(Rewriter &R, FileID FID, const Preprocessor& PP) {
     // get highlighted.
     Expansion = "<span class='macro_popup'>" + Expansion + "</span></span>";
 
-    HighlightRange(R, LLoc.getBegin(), LLoc.getEnd(), "<span class='macro'>",
-                   Expansion.c_str(), LLoc.isTokenRange());
+    unsigned B = SM.getFileOffset(LLoc.getBegin());
+    unsigned E = SM.getFileOffset(LLoc.getEnd());
+    if (LLoc.isTokenRange())
+      E += Lexer::MeasureTokenLength(LLoc.getEnd(), SM, R.getLangOpts());
+
+    HighlightRange(RB, B, E, BufferStart, "<span class='macro'>",
+                   Expansion.c_str());
+    if (Highlights)
+      Highlights->push_back({B, E, "<span class='macro'>", Expansion});
   }
 
   // Restore the preprocessor's old state.
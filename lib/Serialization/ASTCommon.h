@@ -124,6 +124,38 @@ inline bool isPartOfPerModuleInitializer(const Decl *D) {
   return false;
 }
 
+/// Encode \p Loc relative to \p BaseOffset, the offset of the source location
+/// entry that refers to it.
+///
+/// Macro expansion entries mostly refer to locations shortly before
+/// themselves, such as the spelling of a macro argument or the enclosing
+/// expansion, so the encoded values are much smaller than raw locations.
+/// Zero denotes an invalid location.
+inline uint64_t encodeRelativeSourceLocation(SourceLocation Loc,
+                                             unsigned BaseOffset) {
+  if (Loc.isInvalid())
+    return 0;
+  int64_t Delta = int64_t(Loc.getOffset()) - int64_t(BaseOffset);
+  uint64_t ZigZag = (uint64_t(Delta) << 1) ^ uint64_t(Delta >> 63);
+  return ((ZigZag << 1) | uint64_t(Loc.isMacroID())) + 1;
+}
+
+/// Decode a location written by \c encodeRelativeSourceLocation. The result
+/// is in the address space of the AST file that contains it.
+inline SourceLocation decodeRelativeSourceLocation(uint64_t Value,
+                                                   unsigned BaseOffset) {
+  if (Value == 0)
+    return SourceLocation();
+  --Value;
+  bool IsMacroID = Value & 1;
+  uint64_t ZigZag = Value >> 1;
+  int64_t Delta = int64_t(ZigZag >> 1) ^ -int64_t(ZigZag & 1);
+  unsigned Raw = unsigned(int64_t(BaseOffset) + Delta);
+  if (IsMacroID)
+    Raw |= 1U << 31;
+  return SourceLocation::getFromRawEncoding(Raw);
+}
+
 } // namespace serialization
 
 } // namespace clang
@@ -113,6 +113,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include "llvm/Support/TimeProfiler.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/VersionTuple.h"
 #include "llvm/Support/raw_ostream.h"
@@ -1490,14 +1491,20 @@ bool ASTReader::ReadSLocEntry(int ID) {
   }
 
   case SM_SLOC_EXPANSION_ENTRY: {
-    SourceLocation SpellingLoc = ReadSourceLocation(*F, Record[1]);
-    SourceMgr.createExpansionLoc(SpellingLoc,
-                                     ReadSourceLocation(*F, Record[2]),
-                                     ReadSourceLocation(*F, Record[3]),
-                                     Record[5],
-                                     Record[4],
-                                     ID,
-                                     BaseOffset + Record[0]);
+    // The locations are relative to the entry's offset in the AST file, which
+    // does not include the two dummy entries.
+    unsigned EntryOffset = Record[0] + 2;
+    auto ReadRelativeLoc = [&](uint64_t Value) {
+      return TranslateSourceLocation(
+          *F, decodeRelativeSourceLocation(Value, EntryOffset));
+    };
+    SourceMgr.createExpansionLoc(ReadRelativeLoc(Record[1]),
+                                 ReadRelativeLoc(Record[2]),
+                                 ReadRelativeLoc(Record[3]),
+                                 Record[5],
+                                 Record[4],
+                                 ID,
+                                 BaseOffset + Record[0]);
     break;
   }
   }
@@ -2231,6 +2238,20 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   return IF;
 }
 
+void ASTReader::prefetchInputFileStats(ModuleFile &F, unsigned NumInputs) {
+  std::vector<std::string> Paths;
+  for (unsigned I = 0; I < NumInputs; ++I) {
+    const InputFile &Loaded = F.InputFilesLoaded[I];
+    if (Loaded.getFile() || Loaded.isNotFound())
+      continue;
+    InputFileInfo FI = readInputFileInfo(F, I + 1);
+    // Overridden and transient files are not validated against the disk.
+    if (!FI.Overridden && !FI.Transient)
+      Paths.push_back(std::move(FI.Filename));
+  }
+  FileMgr.prefetchFileStats(Paths);
+}
+
 /// If we are loading a relocatable PCH or module file, and the filename
 /// is not an absolute path, add the system or module root to the beginning of
 /// the file name.
@@ -2398,6 +2419,7 @@ ASTReader::ReadControlBlock(ModuleFile &F,
              F.Kind == MK_ImplicitModule))
           N = NumInputs;
 
+        prefetchInputFileStats(F, N);
         for (unsigned I = 0; I < N; ++I) {
           InputFile IF = getInputFile(F, I+1, Complain);
           if (!IF.getFile() || IF.isOutOfDate())
@@ -3860,6 +3882,8 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
                                             SourceLocation ImportLoc,
                                             unsigned ClientLoadCapabilities,
                                             SmallVectorImpl<ImportedSubmodule> *Imported) {
+  llvm::TimeTraceScope TimeScope("ReadAST", FileName);
+
   llvm::SaveAndRestore<SourceLocation>
     SetCurImportLocRAII(CurrentImportLoc, ImportLoc);
 
@@ -1929,6 +1929,7 @@ static unsigned CreateSLocExpansionAbbrev(llvm::BitstreamWriter &Stream) {
   auto Abbrev = std::make_shared<BitCodeAbbrev>();
   Abbrev->Add(BitCodeAbbrevOp(SM_SLOC_EXPANSION_ENTRY));
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Offset
+  // The locations are relative to the offset of the entry.
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Spelling location
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Start location
   Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // End location
@@ -2343,12 +2344,15 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
     } else {
       // The source location entry is a macro expansion.
       const SrcMgr::ExpansionInfo &Expansion = SLoc->getExpansion();
-      AddSourceLocation(Expansion.getSpellingLoc(), Record);
-      AddSourceLocation(Expansion.getExpansionLocStart(), Record);
-      AddSourceLocation(Expansion.isMacroArgExpansion()
-                            ? SourceLocation()
-                            : Expansion.getExpansionLocEnd(),
-                        Record);
+      unsigned BaseOffset = SLoc->getOffset();
+      Record.push_back(
+          encodeRelativeSourceLocation(Expansion.getSpellingLoc(), BaseOffset));
+      Record.push_back(encodeRelativeSourceLocation(
+          Expansion.getExpansionLocStart(), BaseOffset));
+      Record.push_back(encodeRelativeSourceLocation(
+          Expansion.isMacroArgExpansion() ? SourceLocation()
+                                          : Expansion.getExpansionLocEnd(),
+          BaseOffset));
       Record.push_back(Expansion.isExpansionTokenRange());
 
       // Compute the token length for this macro expansion.
@@ -60,6 +60,7 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <iterator>
 #include <memory>
@@ -79,6 +80,15 @@ STATISTIC(MaxBugClassSize,
 STATISTIC(MaxValidBugClassSize,
           "The maximum number of bug reports in the same equivalence class "
           "where at least one report is valid (not suppressed)");
+STATISTIC(NumReportGraphsTried,
+          "The # of report paths sliced from the trimmed graph and checked by "
+          "visitors");
+STATISTIC(NumEQClassesOverTimeBudget,
+          "The # of equivalence classes whose path generation gave up "
+          "because it ran out of time");
+STATISTIC(MaxPathGenerationTime,
+          "The maximum time in milliseconds spent finding a valid report in "
+          "an equivalence class");
 
 BugReporterVisitor::~BugReporterVisitor() = default;
 
@@ -2238,8 +2248,6 @@ PathDiagnosticLocation BugReport::getLocation(const SourceManager &SM) const {
 
 BugReportEquivClass::~BugReportEquivClass() = default;
 
-GRBugReporter::~GRBugReporter() = default;
-
 BugReporterData::~BugReporterData() = default;
 
 ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
@@ -2247,6 +2255,12 @@ ExplodedGraph &GRBugReporter::getGraph() { return Eng.getGraph(); }
 ProgramStateManager&
 GRBugReporter::getStateManager() { return Eng.getStateManager(); }
 
+RefutationSolver &GRBugReporter::getRefutationSolver() {
+  if (!Refutation)
+    Refutation = llvm::make_unique<RefutationSolver>();
+  return *Refutation;
+}
+
 BugReporter::~BugReporter() {
   FlushReports();
 
@@ -2290,49 +2304,52 @@ public:
   size_t Index;
 };
 
-/// A wrapper around a trimmed graph and its node maps.
-class TrimmedGraph {
-  InterExplodedGraphMap InverseMap;
-
+/// A helper class for sorting ExplodedNodes by priority.
+template <bool Descending>
+class PriorityCompare {
   using PriorityMapTy = llvm::DenseMap<const ExplodedNode *, unsigned>;
+  using NodeIndexPair = std::pair<const ExplodedNode *, size_t>;
 
-  PriorityMapTy PriorityMap;
+  const PriorityMapTy &PriorityMap;
 
-  using NodeIndexPair = std::pair<const ExplodedNode *, size_t>;
+public:
+  PriorityCompare(const PriorityMapTy &M) : PriorityMap(M) {}
 
-  SmallVector<NodeIndexPair, 32> ReportNodes;
+  bool operator()(const ExplodedNode *LHS, const ExplodedNode *RHS) const {
+    PriorityMapTy::const_iterator LI = PriorityMap.find(LHS);
+    PriorityMapTy::const_iterator RI = PriorityMap.find(RHS);
+    PriorityMapTy::const_iterator E = PriorityMap.end();
 
-  std::unique_ptr<ExplodedGraph> G;
+    if (LI == E)
+      return Descending;
+    if (RI == E)
+      return !Descending;
 
-  /// A helper class for sorting ExplodedNodes by priority.
-  template <bool Descending>
-  class PriorityCompare {
-    const PriorityMapTy &PriorityMap;
+    return Descending ? LI->second > RI->second
+                      : LI->second < RI->second;
+  }
 
-  public:
-    PriorityCompare(const PriorityMapTy &M) : PriorityMap(M) {}
+  bool operator()(const NodeIndexPair &LHS, const NodeIndexPair &RHS) const {
+    return (*this)(LHS.first, RHS.first);
+  }
+};
 
-    bool operator()(const ExplodedNode *LHS, const ExplodedNode *RHS) const {
-      PriorityMapTy::const_iterator LI = PriorityMap.find(LHS);
-      PriorityMapTy::const_iterator RI = PriorityMap.find(RHS);
-      PriorityMapTy::const_iterator E = PriorityMap.end();
+/// A wrapper around the trimmed graph of a single equivalence class.
+class TrimmedGraph {
+  using NodeIndexPair = std::pair<const ExplodedNode *, size_t>;
 
-      if (LI == E)
-        return Descending;
-      if (RI == E)
-        return !Descending;
+  SmallVector<NodeIndexPair, 32> ReportNodes;
 
-      return Descending ? LI->second > RI->second
-                        : LI->second < RI->second;
-    }
+  /// The trimmed graph, if it is not shared with other equivalence classes.
+  std::unique_ptr<TrimmedExplodedGraph> OwnTrimmed;
 
-    bool operator()(const NodeIndexPair &LHS, const NodeIndexPair &RHS) const {
-      return (*this)(LHS.first, RHS.first);
-    }
-  };
+  const TrimmedExplodedGraph *Trimmed;
 
 public:
-  TrimmedGraph(const ExplodedGraph *OriginalGraph,
+  /// Slices the report graphs for \p Nodes from \p Shared if it contains all
+  /// of them, or from a graph trimmed for \p Nodes alone otherwise.
+  TrimmedGraph(const TrimmedExplodedGraph *Shared,
+               const ExplodedGraph *OriginalGraph,
                ArrayRef<const ExplodedNode *> Nodes);
 
   bool popNextReportGraph(ReportGraph &GraphWrapper);
@@ -2340,28 +2357,41 @@ public:
 
 } // namespace
 
-TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
-                           ArrayRef<const ExplodedNode *> Nodes) {
-  // The trimmed graph is created in the body of the constructor to ensure
-  // that the DenseMaps have been initialized already.
+namespace clang {
+namespace ento {
+
+/// An exploded graph trimmed to the paths that lead to a set of error nodes,
+/// and its node maps.
+class TrimmedExplodedGraph {
+public:
   InterExplodedGraphMap ForwardMap;
-  G = OriginalGraph->trim(Nodes, &ForwardMap, &InverseMap);
+  InterExplodedGraphMap InverseMap;
+  std::unique_ptr<ExplodedGraph> G;
 
-  // Find the (first) error node in the trimmed graph.  We just need to consult
-  // the node map which maps from nodes in the original graph to nodes
-  // in the new graph.
-  llvm::SmallPtrSet<const ExplodedNode *, 32> RemainingNodes;
+  /// The order in which a BFS from the root reaches each node, which makes
+  /// the path to a node through the lowest numbered predecessors a shortest
+  /// one.
+  llvm::DenseMap<const ExplodedNode *, unsigned> PriorityMap;
 
-  for (unsigned i = 0, count = Nodes.size(); i < count; ++i) {
-    if (const ExplodedNode *NewNode = ForwardMap.lookup(Nodes[i])) {
-      ReportNodes.push_back(std::make_pair(NewNode, i));
-      RemainingNodes.insert(NewNode);
-    }
-  }
+  TrimmedExplodedGraph(const ExplodedGraph *OriginalGraph,
+                       ArrayRef<const ExplodedNode *> Nodes);
+};
+
+} // namespace ento
+} // namespace clang
 
-  assert(!RemainingNodes.empty() && "No error node found in the trimmed graph");
+TrimmedExplodedGraph::TrimmedExplodedGraph(
+    const ExplodedGraph *OriginalGraph, ArrayRef<const ExplodedNode *> Nodes) {
+  // The trimmed graph is created in the body of the constructor to ensure
+  // that the DenseMaps have been initialized already.
+  G = OriginalGraph->trim(Nodes, &ForwardMap, &InverseMap);
 
   // Perform a forward BFS to find all the shortest paths.
+  //
+  // The nodes that lead to the error nodes of one equivalence class have no
+  // predecessors outside that set, so they are numbered in the same relative
+  // order as in a graph trimmed for that class alone. The graph can therefore
+  // be shared between classes without changing the paths that are picked.
   std::queue<const ExplodedNode *> WS;
 
   assert(G->num_roots() == 1);
@@ -2372,29 +2402,48 @@ TrimmedGraph::TrimmedGraph(const ExplodedGraph *OriginalGraph,
     const ExplodedNode *Node = WS.front();
     WS.pop();
 
-    PriorityMapTy::iterator PriorityEntry;
-    bool IsNew;
-    std::tie(PriorityEntry, IsNew) =
-      PriorityMap.insert(std::make_pair(Node, Priority));
+    bool IsNew = PriorityMap.insert(std::make_pair(Node, Priority)).second;
     ++Priority;
 
-    if (!IsNew) {
-      assert(PriorityEntry->second <= Priority);
+    if (!IsNew)
       continue;
-    }
-
-    if (RemainingNodes.erase(Node))
-      if (RemainingNodes.empty())
-        break;
 
     for (ExplodedNode::const_pred_iterator I = Node->succ_begin(),
                                            E = Node->succ_end();
          I != E; ++I)
       WS.push(*I);
   }
+}
+
+GRBugReporter::~GRBugReporter() = default;
+
+TrimmedGraph::TrimmedGraph(const TrimmedExplodedGraph *Shared,
+                           const ExplodedGraph *OriginalGraph,
+                           ArrayRef<const ExplodedNode *> Nodes)
+    : Trimmed(Shared) {
+  if (Trimmed && llvm::any_of(Nodes, [&](const ExplodedNode *N) {
+        return N && !Trimmed->ForwardMap.count(N);
+      }))
+    Trimmed = nullptr;
+  if (!Trimmed) {
+    OwnTrimmed = llvm::make_unique<TrimmedExplodedGraph>(OriginalGraph, Nodes);
+    Trimmed = OwnTrimmed.get();
+  }
+
+  // Find the (first) error node in the trimmed graph.  We just need to consult
+  // the node map which maps from nodes in the original graph to nodes
+  // in the new graph.
+  for (unsigned i = 0, count = Nodes.size(); i < count; ++i) {
+    if (!Nodes[i])
+      continue;
+    if (const ExplodedNode *NewNode = Trimmed->ForwardMap.lookup(Nodes[i]))
+      ReportNodes.push_back(std::make_pair(NewNode, i));
+  }
+
+  assert(!ReportNodes.empty() && "No error node found in the trimmed graph");
 
   // Sort the error paths from longest to shortest.
-  llvm::sort(ReportNodes, PriorityCompare<true>(PriorityMap));
+  llvm::sort(ReportNodes, PriorityCompare<true>(Trimmed->PriorityMap));
 }
 
 bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
@@ -2403,6 +2452,7 @@ bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
 
   const ExplodedNode *OrigN;
   std::tie(OrigN, GraphWrapper.Index) = ReportNodes.pop_back_val();
+  const auto &PriorityMap = Trimmed->PriorityMap;
   assert(PriorityMap.find(OrigN) != PriorityMap.end() &&
          "error node not accessible from root");
 
@@ -2421,8 +2471,10 @@ bool TrimmedGraph::popNextReportGraph(ReportGraph &GraphWrapper) {
                                        OrigN->isSink());
 
     // Store the mapping to the original node.
-    InterExplodedGraphMap::const_iterator IMitr = InverseMap.find(OrigN);
-    assert(IMitr != InverseMap.end() && "No mapping to original node.");
+    InterExplodedGraphMap::const_iterator IMitr =
+        Trimmed->InverseMap.find(OrigN);
+    assert(IMitr != Trimmed->InverseMap.end() &&
+           "No mapping to original node.");
     GraphWrapper.BackMap[NewN] = IMitr->second;
 
     // Link up the new node with the previous node.
@@ -2607,8 +2659,11 @@ std::pair<BugReport*, std::unique_ptr<VisitorsDiagnosticsTy>> findValidReport(
   ArrayRef<BugReport *> &bugReports,
   AnalyzerOptions &Opts,
   GRBugReporter &Reporter) {
+  auto Start = std::chrono::steady_clock::now();
 
   while (TrimG.popNextReportGraph(ErrorGraph)) {
+    ++NumReportGraphsTried;
+
     // Find the BugReport with the original location.
     assert(ErrorGraph.Index < bugReports.size());
     BugReport *R = bugReports[ErrorGraph.Index];
@@ -2647,6 +2702,15 @@ std::pair<BugReport*, std::unique_ptr<VisitorsDiagnosticsTy>> findValidReport(
       if (R->isValid())
         return std::make_pair(R, std::move(visitorNotes));
     }
+
+    // Give up on the remaining reports of the class once the time budget is
+    // spent.
+    if (Opts.PathGenerationTimeBudget &&
+        std::chrono::steady_clock::now() - Start >=
+            std::chrono::milliseconds(Opts.PathGenerationTimeBudget)) {
+      ++NumEQClassesOverTimeBudget;
+      break;
+    }
   }
 
   return std::make_pair(nullptr, llvm::make_unique<VisitorsDiagnosticsTy>());
@@ -2676,10 +2740,27 @@ GRBugReporter::generatePathDiagnostics(
   if (!HasValid)
     return Out;
 
-  TrimmedGraph TrimG(&getGraph(), errorNodes);
+  // Trim the graph once for the reports of every equivalence class, rather
+  // than once per class.
+  if (!TrimmedGraphForAllReports) {
+    SmallVector<const ExplodedNode *, 32> AllErrorNodes;
+    for (auto EQ = EQClasses_begin(), E = EQClasses_end(); EQ != E; ++EQ)
+      for (BugReport &Report : *EQ)
+        if (Report.isValid() && Report.getErrorNode())
+          AllErrorNodes.push_back(Report.getErrorNode());
+    TrimmedGraphForAllReports =
+        llvm::make_unique<TrimmedExplodedGraph>(&getGraph(), AllErrorNodes);
+  }
+
+  TrimmedGraph TrimG(TrimmedGraphForAllReports.get(), &getGraph(), errorNodes);
   ReportGraph ErrorGraph;
+  auto Start = std::chrono::steady_clock::now();
   auto ReportInfo = findValidReport(TrimG, ErrorGraph, bugReports,
                   getAnalyzerOptions(), *this);
+  MaxPathGenerationTime.updateMax(static_cast<unsigned>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - Start)
+          .count()));
   BugReport *R = ReportInfo.first;
 
   if (R && R->isValid()) {
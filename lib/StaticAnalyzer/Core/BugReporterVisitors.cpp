@@ -52,12 +52,14 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
@@ -66,6 +68,18 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "BugReporterVisitors"
+
+STATISTIC(NumRefutationQueries,
+          "The # of bug report paths crosschecked with the SMT solver");
+STATISTIC(NumRefutationCacheHits,
+          "The # of crosschecked paths whose constraints were checked before");
+STATISTIC(NumRefutationScopesReused,
+          "The # of solver scopes kept from the previous crosschecked path");
+STATISTIC(RefutationSolverTime,
+          "The time in microseconds spent by the SMT solver crosschecking "
+          "bug report paths");
+
 //===----------------------------------------------------------------------===//
 // Utility functions.
 //===----------------------------------------------------------------------===//
@@ -2594,38 +2608,97 @@ UndefOrNullArgVisitor::VisitNode(const ExplodedNode *N,
 // Implementation of FalsePositiveRefutationBRVisitor.
 //===----------------------------------------------------------------------===//
 
-FalsePositiveRefutationBRVisitor::FalsePositiveRefutationBRVisitor()
-    : Constraints(ConstraintRangeTy::Factory().getEmptyMap()) {}
+/// Returns the constraint that \p Sym is in one of \p Ranges.
+static llvm::SMTExprRef getRangeSetExpr(llvm::SMTSolverRef &Solver,
+                                        ASTContext &Ctx, SymbolRef Sym,
+                                        const RangeSet &Ranges) {
+  auto RangeIt = Ranges.begin();
+  llvm::SMTExprRef Constraints =
+      SMTConv::getRangeExpr(Solver, Ctx, Sym, RangeIt->From(), RangeIt->To(),
+                            /*InRange=*/true);
+  while ((++RangeIt) != Ranges.end()) {
+    Constraints = Solver->mkOr(
+        Constraints, SMTConv::getRangeExpr(Solver, Ctx, Sym, RangeIt->From(),
+                                           RangeIt->To(), /*InRange=*/true));
+  }
+  return Constraints;
+}
 
-void FalsePositiveRefutationBRVisitor::finalizeVisitor(
-    BugReporterContext &BRC, const ExplodedNode *EndPathNode, BugReport &BR) {
-  // Collect new constraints
-  VisitNode(EndPathNode, BRC, BR);
-
-  // Create a refutation manager
-  llvm::SMTSolverRef RefutationSolver = llvm::CreateZ3Solver();
-  ASTContext &Ctx = BRC.getASTContext();
-
-  // Add constraints to the solver
-  for (const auto &I : Constraints) {
-    const SymbolRef Sym = I.first;
-    auto RangeIt = I.second.begin();
-
-    llvm::SMTExprRef Constraints = SMTConv::getRangeExpr(
-        RefutationSolver, Ctx, Sym, RangeIt->From(), RangeIt->To(),
-        /*InRange=*/true);
-    while ((++RangeIt) != I.second.end()) {
-      Constraints = RefutationSolver->mkOr(
-          Constraints, SMTConv::getRangeExpr(RefutationSolver, Ctx, Sym,
-                                             RangeIt->From(), RangeIt->To(),
-                                             /*InRange=*/true));
+RefutationSolver::RefutationSolver(llvm::SMTSolverRef Solver)
+    : Solver(std::move(Solver)) {}
+
+Optional<bool> RefutationSolver::check(ASTContext &Ctx,
+                                       ArrayRef<ConstraintRangeTy> Steps,
+                                       ConstraintRangeTy Constraints) {
+  ++NumRefutationQueries;
+  auto Known = Results.find(Constraints.getRootWithoutRetain());
+  if (Known != Results.end()) {
+    ++NumRefutationCacheHits;
+    return Known->second.second;
+  }
+
+  // Keep the scopes of the steps that this path shares with the last one.
+  auto Step = Steps.rbegin(), StepEnd = Steps.rend();
+  unsigned NumShared = 0;
+  while (NumShared != Scopes.size() && Step != StepEnd &&
+         Scopes[NumShared] == *Step) {
+    ++NumShared;
+    ++Step;
+  }
+  if (NumShared != Scopes.size()) {
+    Solver->pop(Scopes.size() - NumShared);
+    Scopes.erase(Scopes.begin() + NumShared, Scopes.end());
+  }
+  NumRefutationScopesReused += NumShared;
+
+  // The range of a symbol only ever narrows along a path, so asserting the
+  // constraints that each step adds is the same as asserting the tightest
+  // constraint on each symbol.
+  for (; Step != StepEnd; ++Step) {
+    Solver->push();
+    for (const auto &I : *Step) {
+      if (!Scopes.empty()) {
+        const RangeSet *Prev = Scopes.back().lookup(I.first);
+        if (Prev && *Prev == I.second)
+          continue;
+      }
+      Solver->addConstraint(getRangeSetExpr(Solver, Ctx, I.first, I.second));
     }
-
-    RefutationSolver->addConstraint(Constraints);
+    Scopes.push_back(*Step);
   }
 
+  auto Start = std::chrono::steady_clock::now();
+  Optional<bool> IsSat = Solver->check();
+  RefutationSolverTime += static_cast<unsigned>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - Start)
+          .count());
+
+  Results.try_emplace(Constraints.getRootWithoutRetain(), Constraints, IsSat);
+  return IsSat;
+}
+
+void FalsePositiveRefutationBRVisitor::finalizeVisitor(
+    BugReporterContext &BRC, const ExplodedNode *EndPathNode, BugReport &BR) {
+  // The error node is visited last, but it is the bottom of the path.
+  const ConstraintRangeTy &EndCs =
+      EndPathNode->getState()->get<ConstraintRange>();
+  if (Steps.empty() || Steps.front() != EndCs)
+    Steps.insert(Steps.begin(), EndCs);
+
+  // Collect the tightest constraint on each symbol, which is the one closest
+  // to the error node.
+  ConstraintRangeTy::Factory &CF =
+      EndPathNode->getState()->get_context<ConstraintRange>();
+  ConstraintRangeTy Constraints = CF.getEmptyMap();
+  for (const ConstraintRangeTy &Cs : Steps)
+    for (const auto &C : Cs)
+      if (!Constraints.contains(C.first))
+        Constraints = CF.add(Constraints, C.first, C.second);
+
   // And check for satisfiability
-  Optional<bool> isSat = RefutationSolver->check();
+  Optional<bool> isSat = BRC.getBugReporter().getRefutationSolver().check(
+      BRC.getASTContext(), Steps, Constraints);
   if (!isSat.hasValue())
     return;
 
@@ -2638,17 +2711,9 @@ FalsePositiveRefutationBRVisitor::VisitNode(const ExplodedNode *N,
                                             BugReporterContext &,
                                             BugReport &) {
   // Collect new constraints
-  const ConstraintRangeTy &NewCs = N->getState()->get<ConstraintRange>();
-  ConstraintRangeTy::Factory &CF =
-      N->getState()->get_context<ConstraintRange>();
-
-  // Add constraints if we don't have them yet
-  for (auto const &C : NewCs) {
-    const SymbolRef &Sym = C.first;
-    if (!Constraints.contains(Sym)) {
-      Constraints = CF.add(Constraints, Sym, C.second);
-    }
-  }
+  const ConstraintRangeTy &Cs = N->getState()->get<ConstraintRange>();
+  if (Steps.empty() || Steps.back() != Cs)
+    Steps.push_back(Cs);
 
   return nullptr;
 }
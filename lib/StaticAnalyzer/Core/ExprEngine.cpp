@@ -75,6 +75,7 @@
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -89,6 +90,13 @@ using namespace ento;
 
 STATISTIC(NumRemoveDeadBindings,
             "The # of times RemoveDeadBindings is called");
+STATISTIC(NumRemoveDeadExpressions,
+            "The # of times only the dead expression bindings were removed");
+STATISTIC(NumCleanNodesSaved,
+            "The # of nodes not created because removing dead expression "
+            "bindings left the state unchanged");
+STATISTIC(RemoveDeadTime,
+            "The time in microseconds spent removing dead bindings");
 STATISTIC(NumMaxBlockCountReached,
             "The # of aborted paths due to reaching the maximum block count in "
             "a top level function");
@@ -709,6 +717,7 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
   }
 
   NumRemoveDeadBindings++;
+  auto Start = std::chrono::steady_clock::now();
   ProgramStateRef CleanedState = Pred->getState();
 
   // LC is the location context being destroyed, but SymbolReaper wants a
@@ -770,6 +779,45 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
         StateMgr.getPersistentStateWithGDM(CleanedState, CheckerState);
     Bldr.generateNode(DiagnosticStmt, I, CleanedCheckerSt, &cleanupTag, K);
   }
+
+  RemoveDeadTime += static_cast<unsigned>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - Start)
+          .count());
+}
+
+void ExprEngine::removeDeadExpressions(ExplodedNode *Pred,
+                                       ExplodedNodeSet &Out,
+                                       const Stmt *ReferenceStmt,
+                                       const LocationContext *LC) {
+  NumRemoveDeadExpressions++;
+  auto Start = std::chrono::steady_clock::now();
+
+  // The symbols that the environment refers to are marked live as a side
+  // effect, but nothing else looks at them, because the store and the
+  // constraints are kept until the next full collection.
+  SymbolReaper SymReaper(LC->getStackFrame(), ReferenceStmt, SymMgr,
+                         getStoreManager());
+  ProgramStateRef CleanedState =
+      StateMgr.removeDeadExpressionBindings(Pred->getState(), SymReaper);
+
+  // States are uniqued, so an unchanged state means that there was nothing to
+  // remove and no new node is needed.
+  if (CleanedState == Pred->getState()) {
+    NumCleanNodesSaved++;
+    Out.Add(Pred);
+  } else {
+    static SimpleProgramPointTag cleanupTag(TagProviderName,
+                                            "Clean Expressions");
+    StmtNodeBuilder Bldr(Pred, Out, *currBldrCtx);
+    Bldr.generateNode(ReferenceStmt, Pred, CleanedState, &cleanupTag,
+                      ProgramPoint::PreStmtPurgeDeadSymbolsKind);
+  }
+
+  RemoveDeadTime += static_cast<unsigned>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - Start)
+          .count());
 }
 
 void ExprEngine::ProcessStmt(const Stmt *currStmt, ExplodedNode *Pred) {
@@ -784,8 +832,16 @@ void ExprEngine::ProcessStmt(const Stmt *currStmt, ExplodedNode *Pred) {
   ExplodedNodeSet CleanedStates;
   if (shouldRemoveDeadBindings(AMgr, currStmt, Pred,
                                Pred->getLocationContext())) {
-    removeDead(Pred, CleanedStates, currStmt,
-                                    Pred->getLocationContext());
+    // In the block purge mode the store, the constraints and the checker
+    // states are only collected at the beginning of a basic block. Within
+    // the block, only the values of the consumed expressions are dropped,
+    // which is cheap and still lets equal states merge.
+    if (AMgr.options.AnalysisPurgeOpt == PurgeBlock &&
+        !Pred->getLocation().getAs<BlockEntrance>())
+      removeDeadExpressions(Pred, CleanedStates, currStmt,
+                            Pred->getLocationContext());
+    else
+      removeDead(Pred, CleanedStates, currStmt, Pred->getLocationContext());
   } else
     CleanedStates.Add(Pred);
 
@@ -36,6 +36,8 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
@@ -65,6 +67,14 @@ class HTMLDiagnostics : public PathDiagnosticConsumer {
   AnalyzerOptions &AnalyzerOpts;
   const bool SupportsCrossFileDiagnostics;
 
+  /// The syntax and macro highlighting of the files that reports were
+  /// rendered for, which the reports in the same files reuse.
+  html::HighlightCache Highlights;
+
+  /// The threads that write the rendered reports to disk, which are started
+  /// with the first report.
+  std::unique_ptr<llvm::ThreadPool> Writers;
+
 public:
   HTMLDiagnostics(AnalyzerOptions &AnalyzerOpts,
                   const std::string& prefix,
@@ -114,6 +124,9 @@ public:
   // Rewrite the file specified by FID with HTML formatting.
   void RewriteFile(Rewriter &R, const PathPieces& path, FileID FID);
 
+  // Write a rendered report to the file descriptor FD, and close it.
+  void WriteReport(int FD, std::string Report);
+
 
 private:
   /// \return Javascript for displaying shortcuts help;
@@ -157,6 +170,9 @@ void HTMLDiagnostics::FlushDiagnosticsImpl(
   FilesMade *filesMade) {
   for (const auto Diag : Diags)
     ReportDiag(*Diag, filesMade);
+
+  if (Writers)
+    Writers->wait();
 }
 
 void HTMLDiagnostics::ReportDiag(const PathDiagnostic& D,
@@ -258,14 +274,26 @@ void HTMLDiagnostics::ReportDiag(const PathDiagnostic& D,
       } while (EC);
   }
 
-  llvm::raw_fd_ostream os(FD, true);
-
   if (filesMade)
     filesMade->addDiagnostic(D, getName(),
                              llvm::sys::path::filename(ResultPath));
 
   // Emit the HTML to disk.
-  os << report;
+  WriteReport(FD, std::move(report));
+}
+
+void HTMLDiagnostics::WriteReport(int FD, std::string Report) {
+  // Rendering a report needs the source manager and the preprocessor, which
+  // are not thread safe, but writing it does not, so it overlaps with
+  // rendering the next one.
+  if (!Writers)
+    Writers = llvm::make_unique<llvm::ThreadPool>(
+        std::min(llvm::hardware_concurrency(), 4u));
+
+  Writers->async([FD, Report = std::move(Report)] {
+    llvm::raw_fd_ostream os(FD, /*shouldClose=*/true);
+    os << Report;
+  });
 }
 
 std::string HTMLDiagnostics::GenerateHTML(const PathDiagnostic& D, Rewriter &R,
@@ -730,8 +758,8 @@ void HTMLDiagnostics::RewriteFile(Rewriter &R,
   // If we have a preprocessor, relex the file and syntax highlight.
   // We might not have a preprocessor if we come from a deserialized AST file,
   // for example.
-  html::SyntaxHighlight(R, FID, PP);
-  html::HighlightMacros(R, FID, PP);
+  html::SyntaxHighlight(R, FID, PP, &Highlights);
+  html::HighlightMacros(R, FID, PP, &Highlights);
 }
 
 void HTMLDiagnostics::HandlePiece(Rewriter &R, FileID BugFileID,
@@ -116,6 +116,14 @@ ProgramStateManager::removeDeadBindings(ProgramStateRef state,
   return ConstraintMgr->removeDeadBindings(Result, SymReaper);
 }
 
+ProgramStateRef
+ProgramStateManager::removeDeadExpressionBindings(ProgramStateRef state,
+                                                  SymbolReaper &SymReaper) {
+  ProgramState NewState = *state;
+  NewState.Env = EnvMgr.removeDeadBindings(NewState.Env, SymReaper, state);
+  return getPersistentState(NewState);
+}
+
 ProgramStateRef ProgramState::bindLoc(Loc LV,
                                       SVal V,
                                       const LocationContext *LCtx,
@@ -14,10 +14,13 @@
 
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PriorityQueue.h"
 
 #include <limits>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace llvm;
@@ -134,6 +137,9 @@ public:
   // Maps preorder indices to postorder ones.
   std::vector<int> PostorderIds;
   std::vector<NodeId> NodesBfs;
+  /// Hashes of the subtrees rooted at each node, indexed by preorder id.
+  /// Identical subtrees have equal hashes.
+  std::vector<llvm::hash_code> SubtreeHashes;
 
   int getSize() const { return Nodes.size(); }
   NodeId getRootId() const { return 0; }
@@ -157,6 +163,10 @@ public:
   std::string getDeclValue(const Decl *D) const;
   std::string getStmtValue(const Stmt *S) const;
 
+  /// Computes SubtreeHashes, unless that was already done.
+  void computeSubtreeHashes();
+  llvm::hash_code getSubtreeHash(NodeId Id) const { return SubtreeHashes[Id]; }
+
 private:
   void initTree();
   void setLeftMostDescendants();
@@ -405,6 +415,22 @@ static std::string getInitializerValue(const CXXCtorInitializer *Init,
   llvm_unreachable("Unknown initializer type");
 }
 
+void SyntaxTree::Impl::computeSubtreeHashes() {
+  if (!SubtreeHashes.empty())
+    return;
+  SubtreeHashes.resize(getSize());
+  // Children have larger ids than their parent, so visiting the nodes in
+  // reverse preorder sees every subtree before its root.
+  for (int Id = getSize() - 1; Id >= 0; --Id) {
+    const Node &N = getNode(Id);
+    llvm::hash_code Hash = llvm::hash_combine(
+        N.getTypeLabel(), getNodeValue(N), N.Children.size());
+    for (NodeId Child : N.Children)
+      Hash = llvm::hash_combine(Hash, SubtreeHashes[Child]);
+    SubtreeHashes[Id] = Hash;
+  }
+}
+
 std::string SyntaxTree::Impl::getNodeValue(NodeId Id) const {
   return getNodeValue(getNode(Id));
 }
@@ -756,6 +782,8 @@ public:
 } // end anonymous namespace
 
 bool ASTDiff::Impl::identical(NodeId Id1, NodeId Id2) const {
+  if (T1.getSubtreeHash(Id1) != T2.getSubtreeHash(Id2))
+    return false;
   const Node &N1 = T1.getNode(Id1);
   const Node &N2 = T2.getNode(Id2);
   if (N1.Children.size() != N2.Children.size() ||
@@ -815,9 +843,26 @@ double ASTDiff::Impl::getJaccardSimilarity(const Mapping &M, NodeId Id1,
 }
 
 NodeId ASTDiff::Impl::findCandidate(const Mapping &M, NodeId Id1) const {
+  // Only nodes that contain the counterpart of one of Id1's descendants can
+  // have a nonzero similarity, so collect those instead of trying all of T2.
+  std::vector<NodeId> Candidates;
+  llvm::DenseSet<int> Seen;
+  const Node &N1 = T1.getNode(Id1);
+  for (NodeId Src = Id1 + 1; Src <= N1.RightMostDescendant; ++Src) {
+    for (NodeId Dst = M.getDst(Src); Dst.isValid();
+         Dst = T2.getNode(Dst).Parent) {
+      // The ancestors of a node that was seen before have been seen too.
+      if (!Seen.insert(Dst).second)
+        break;
+      Candidates.push_back(Dst);
+    }
+  }
+  // Visit the candidates in preorder to break ties like a full scan would.
+  llvm::sort(Candidates);
+
   NodeId Candidate;
   double HighestSimilarity = 0.0;
-  for (NodeId Id2 : T2) {
+  for (NodeId Id2 : Candidates) {
     if (!isMatchingPossible(Id1, Id2))
       continue;
     if (M.hasDst(Id2))
@@ -881,9 +926,17 @@ Mapping ASTDiff::Impl::matchTopDown() const {
     std::vector<NodeId> H1, H2;
     H1 = L1.pop();
     H2 = L2.pop();
+    // Only subtrees with equal hashes can be identical, so group the right
+    // side by hash instead of comparing every pair.
+    std::unordered_map<size_t, SmallVector<NodeId, 2>> Buckets;
+    for (NodeId Id2 : H2)
+      Buckets[T2.getSubtreeHash(Id2)].push_back(Id2);
     for (NodeId Id1 : H1) {
-      for (NodeId Id2 : H2) {
-        if (identical(Id1, Id2) && !M.hasSrc(Id1) && !M.hasDst(Id2)) {
+      auto Bucket = Buckets.find(T1.getSubtreeHash(Id1));
+      if (Bucket == Buckets.end())
+        continue;
+      for (NodeId Id2 : Bucket->second) {
+        if (!M.hasSrc(Id1) && !M.hasDst(Id2) && identical(Id1, Id2)) {
           for (int I = 0, E = T1.getNumberOfDescendants(Id1); I < E; ++I)
             M.link(Id1 + I, Id2 + I);
         }
@@ -904,6 +957,8 @@ Mapping ASTDiff::Impl::matchTopDown() const {
 ASTDiff::Impl::Impl(SyntaxTree::Impl &T1, SyntaxTree::Impl &T2,
                     const ComparisonOptions &Options)
     : T1(T1), T2(T2), Options(Options) {
+  T1.computeSubtreeHashes();
+  T2.computeSubtreeHashes();
   computeMapping();
   computeChangeKinds(TheMapping);
 }
@@ -0,0 +1,236 @@
+//===--- IndexedRename.cpp - Clang refactoring library --------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Finds the occurrences of symbols to rename in an index store.
+///
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/Refactoring/Rename/IndexedRename.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Index/IndexDataStore.h"
+#include "clang/Index/IndexRecordReader.h"
+#include "clang/Index/IndexUnitReader.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <set>
+
+using namespace llvm;
+
+namespace clang {
+namespace tooling {
+
+namespace {
+
+/// Keeps the contents of the files that occurrences are located in, along
+/// with the offsets of their lines.
+class SourceTextCache {
+  struct FileText {
+    std::unique_ptr<MemoryBuffer> Buffer;
+    std::vector<unsigned> LineOffsets;
+  };
+  StringMap<FileText> Files;
+
+public:
+  /// Returns the offset of the 1-based \p Line and \p Column in \p Path, or
+  /// None if the file cannot be read or is too short.
+  Optional<unsigned> getOffset(StringRef Path, unsigned Line, unsigned Column) {
+    FileText &Text = getText(Path);
+    if (!Text.Buffer || Line == 0 || Column == 0 ||
+        Line > Text.LineOffsets.size())
+      return None;
+    unsigned Offset = Text.LineOffsets[Line - 1] + Column - 1;
+    if (Offset >= Text.Buffer->getBufferSize())
+      return None;
+    return Offset;
+  }
+
+  /// Returns true if \p Name is spelled as a whole identifier at \p Offset.
+  bool isSpelledAt(StringRef Path, unsigned Offset, StringRef Name) {
+    StringRef Buffer = getText(Path).Buffer->getBuffer();
+    StringRef Rest = Buffer.substr(Offset);
+    if (!Rest.startswith(Name))
+      return false;
+    if (Offset > 0 && isIdentifierBody(Buffer[Offset - 1]))
+      return false;
+    return Rest.size() == Name.size() || !isIdentifierBody(Rest[Name.size()]);
+  }
+
+private:
+  FileText &getText(StringRef Path) {
+    auto Known = Files.find(Path);
+    if (Known != Files.end())
+      return Known->second;
+    FileText &Text = Files[Path];
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(Path);
+    if (!Buffer)
+      return Text;
+    Text.Buffer = std::move(*Buffer);
+    StringRef Contents = Text.Buffer->getBuffer();
+    Text.LineOffsets.push_back(0);
+    for (unsigned I = 0, E = Contents.size(); I != E; ++I)
+      if (Contents[I] == '\n')
+        Text.LineOffsets.push_back(I + 1);
+    return Text;
+  }
+};
+
+} // end anonymous namespace
+
+/// Returns true if \p Path changed after \p UnitTime, when the index data for
+/// it was written.
+static bool isModifiedAfter(StringRef Path, sys::TimePoint<> UnitTime) {
+  sys::fs::file_status Status;
+  if (sys::fs::status(Path, Status))
+    return true;
+  return Status.getLastModificationTime() > UnitTime;
+}
+
+Expected<IndexedRenameEdits>
+findIndexedRenameEdits(StringRef StorePath,
+                       const std::vector<std::string> &NewNames,
+                       const std::vector<std::string> &PrevNames,
+                       const std::vector<std::vector<std::string>> &USRList,
+                       bool PrintLocations) {
+  std::string Error;
+  std::unique_ptr<index::IndexDataStore> Store =
+      index::IndexDataStore::create(StorePath, Error);
+  if (!Store)
+    return createStringError(inconvertibleErrorCode(),
+                             "failed to open index store '%s': %s",
+                             StorePath.str().c_str(), Error.c_str());
+
+  // Maps each USR to the rename request it belongs to.
+  StringMap<unsigned> USRToRename;
+  for (unsigned I = 0, E = NewNames.size(); I != E; ++I) {
+    // If the previous name was not found, ignore this rename request.
+    if (PrevNames[I].empty())
+      continue;
+    for (const std::string &USR : USRList[I])
+      USRToRename[USR] = I;
+  }
+
+  std::vector<std::string> UnitNames;
+  Store->foreachUnitName(/*sorted=*/true, [&](StringRef UnitName) {
+    UnitNames.push_back(UnitName.str());
+    return true;
+  });
+
+  IndexedRenameEdits Result;
+  SourceTextCache Sources;
+  StringSet<> ReparsedFiles;
+  // Records are shared between the units that include the same header in
+  // the same configuration, so each is only read once.
+  StringSet<> VisitedRecords;
+  std::set<std::pair<std::string, unsigned>> RenamedOffsets;
+
+  auto Reparse = [&](StringRef MainFile) {
+    if (ReparsedFiles.insert(MainFile).second)
+      Result.FilesToReparse.push_back(MainFile.str());
+  };
+
+  // Adds replacements for the occurrences in a record, and returns false if
+  // some occurrence cannot be renamed without parsing.
+  auto RenameInRecord = [&](StringRef RecordName, StringRef FilePath) {
+    std::unique_ptr<index::IndexRecordReader> Record =
+        index::IndexRecordReader::createWithRecordFilename(RecordName,
+                                                           StorePath, Error);
+    if (!Record)
+      return false;
+
+    SmallVector<const index::IndexRecordDecl *, 4> Decls;
+    Record->searchDecls(
+        [&](const index::IndexRecordDecl &D) {
+          return index::IndexRecordReader::DeclSearchReturn{
+              USRToRename.count(D.USR) != 0, /*ContinueSearch=*/true};
+        },
+        [&](const index::IndexRecordDecl *D) { Decls.push_back(D); });
+    if (Decls.empty())
+      return true;
+
+    bool Complete = true;
+    Record->foreachOccurrence(
+        Decls, None, [&](const index::IndexRecordOccurrence &Occurrence) {
+          // Implicit occurrences have no spelling to rename.
+          if (Occurrence.Roles &
+              static_cast<index::SymbolRoleSet>(index::SymbolRole::Implicit))
+            return true;
+          unsigned I = USRToRename.lookup(Occurrence.Dcl->USR);
+          Optional<unsigned> Offset = Sources.getOffset(
+              FilePath, Occurrence.Line, Occurrence.Column);
+          // The name is not spelled at the recorded location if the
+          // occurrence comes from a macro expansion, or names a destructor.
+          if (!Offset ||
+              !Sources.isSpelledAt(FilePath, *Offset, PrevNames[I])) {
+            Complete = false;
+            return true;
+          }
+          if (!RenamedOffsets.insert({FilePath.str(), *Offset}).second)
+            return true;
+          if (PrintLocations)
+            errs() << "clang-rename: renamed at: " << FilePath << ":"
+                   << Occurrence.Line << ":" << Occurrence.Column << "\n";
+          Replacement Replace(FilePath, *Offset, PrevNames[I].size(),
+                              NewNames[I]);
+          if (auto Err = Result.FileToReplaces[FilePath.str()].add(Replace)) {
+            consumeError(std::move(Err));
+            Complete = false;
+          }
+          return true;
+        });
+    return Complete;
+  };
+
+  for (const std::string &UnitName : UnitNames) {
+    std::unique_ptr<index::IndexUnitReader> Unit =
+        index::IndexUnitReader::createWithUnitFilename(UnitName, StorePath,
+                                                       Error);
+    if (!Unit)
+      return createStringError(inconvertibleErrorCode(),
+                               "failed to read index unit '%s': %s",
+                               UnitName.c_str(), Error.c_str());
+    if (!Unit->hasMainFile() || Unit->isSystemUnit())
+      continue;
+
+    StringRef MainFile = Unit->getMainFilePath();
+    sys::TimePoint<> UnitTime = Unit->getModificationTime();
+    if (isModifiedAfter(MainFile, UnitTime)) {
+      Reparse(MainFile);
+      continue;
+    }
+    Result.IndexedFiles.insert(MainFile);
+
+    Unit->foreachDependency(
+        [&](const index::IndexUnitReader::DependencyInfo &Dep) {
+          if (Dep.Kind != index::IndexUnitReader::DependencyKind::Record ||
+              Dep.IsSystem)
+            return true;
+          // The occurrences in a stale file might have moved, and new ones
+          // are not recorded at all.
+          if (isModifiedAfter(Dep.FilePath, UnitTime)) {
+            Reparse(MainFile);
+            return true;
+          }
+          Result.IndexedFiles.insert(Dep.FilePath);
+          if (!VisitedRecords.insert(Dep.UnitOrRecordName).second)
+            return true;
+          if (!RenameInRecord(Dep.UnitOrRecordName, Dep.FilePath))
+            Reparse(MainFile);
+          return true;
+        });
+  }
+
+  return std::move(Result);
+}
+
+} // end namespace tooling
+} // end namespace clang
@@ -372,6 +372,14 @@ bool FrontendActionFactory::runInvocation(
   return Success;
 }
 
+/// The tool runs every translation unit in this process, so the headers they
+/// have in common only need to be kept in memory once.
+static FileSystemOptions getToolFileSystemOptions() {
+  FileSystemOptions Opts;
+  Opts.ShareFileBuffers = true;
+  return Opts;
+}
+
 ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      ArrayRef<std::string> SourcePaths,
                      std::shared_ptr<PCHContainerOperations> PCHContainerOps,
@@ -382,7 +390,8 @@ ClangTool::ClangTool(const CompilationDatabase &Compilations,
       OverlayFileSystem(new llvm::vfs::OverlayFileSystem(std::move(BaseFS))),
       InMemoryFileSystem(new llvm::vfs::InMemoryFileSystem),
       Files(Files ? Files
-                  : new FileManager(FileSystemOptions(), OverlayFileSystem)) {
+                  : new FileManager(getToolFileSystemOptions(),
+                                    OverlayFileSystem)) {
   OverlayFileSystem->pushOverlay(InMemoryFileSystem);
   appendArgumentsAdjuster(getClangStripOutputAdjuster());
   appendArgumentsAdjuster(getClangSyntaxOnlyAdjuster());
@@ -0,0 +1,32 @@
+// RUN: rm -fR %t
+// RUN: mkdir %t
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=html \
+// RUN:   -analyzer-config stable-report-filename=true -o %t %s
+// RUN: cat %t/report-highlight-cache.c-first-*.html | FileCheck %s
+// RUN: cat %t/report-highlight-cache.c-second-*.html | FileCheck %s
+
+// The file is only highlighted for the first report, and the second one
+// reuses that highlighting, both for the syntax and for the macros.
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=html \
+// RUN:   -analyzer-stats -o %t/stats %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=STATS %s
+// REQUIRES: asserts
+
+#define ZERO 0
+
+int first() {
+  int *p = ZERO;
+  return *p;
+}
+
+int second() {
+  int *p = ZERO;
+  return *p;
+}
+
+// CHECK: <span class='directive'>#define ZERO 0</span>
+// CHECK: <span class='keyword'>int</span>
+// CHECK: <span class='macro_popup'>0</span>
+
+// STATS: {{^ *}}2 HTMLRewrite{{ *}} - The # of file highlightings reused from an earlier rewrite
+// STATS: {{^ *}}2 HTMLRewrite{{ *}} - The # of file highlightings computed by lexing the file
@@ -0,0 +1,20 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,unix.Malloc \
+// RUN:   -analyzer-purge=block -analyzer-stats -verify %s 2>&1 | FileCheck %s
+// REQUIRES: asserts
+
+typedef __typeof(sizeof(int)) size_t;
+void *malloc(size_t);
+void free(void *);
+
+int leak(int x) {
+  int *p = malloc(sizeof(int));
+  x = x + 1;
+  x = x * 2;
+  if (x > 10)
+    return x; // expected-warning{{Potential leak of memory pointed to by 'p'}}
+  free(p);
+  return 0;
+}
+
+// CHECK: ... Statistics Collected ...
+// CHECK-DAG: {{[0-9]+}} ExprEngine - The # of times only the dead expression bindings were removed
@@ -0,0 +1,33 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection \
+// RUN:   -analyzer-config crosscheck-with-z3=true -analyzer-stats -verify %s \
+// RUN:   2>&1 | FileCheck %s
+// REQUIRES: z3, asserts
+
+void clang_analyzer_warnIfReached();
+
+void infeasible(int x) {
+  if ((x & 1) && ((x & 1) ^ 1)) {
+    // Both reports have the same constraints, so the second one is refuted
+    // without asking the solver again.
+    clang_analyzer_warnIfReached(); // no-warning
+    clang_analyzer_warnIfReached(); // no-warning
+  }
+}
+
+int feasible(int x, int y) {
+  // The second path starts with the two steps of the first one, before y is
+  // constrained. Using x and y at the end keeps their constraints alive, so
+  // no step drops them on the way.
+  if (x > 0) {
+    clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+    if (y > 0)
+      clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+  }
+  return x + y;
+}
+
+// Every function has a solver of its own.
+// CHECK: ... Statistics Collected ...
+// CHECK-DAG: {{^ *}}1 BugReporterVisitors - The # of crosschecked paths whose constraints were checked before
+// CHECK-DAG: {{^ *}}4 BugReporterVisitors - The # of bug report paths crosschecked with the SMT solver
+// CHECK-DAG: {{^ *}}2 BugReporterVisitors - The # of solver scopes kept from the previous crosschecked path
@@ -0,0 +1,2 @@
+#pragma once
+template <typename T> T twice(T Value) { return Value + Value; }
@@ -0,0 +1,41 @@
+// REQUIRES: shell
+// RUN: %clangxx -S -ftime-trace -mllvm --time-trace-granularity=0 -o %T/check-time-trace-events %s
+// RUN: cat %T/check-time-trace-events.json \
+// RUN:   | %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   | FileCheck %s
+
+// The header is read from a precompiled header instead.
+// RUN: %clangxx -x c++-header -o %T/check-time-trace-events.pch %S/Inputs/time-trace-header.h
+// RUN: %clangxx -S -ftime-trace -mllvm --time-trace-granularity=0 -include-pch %T/check-time-trace-events.pch -o %T/check-time-trace-events-pch %s
+// RUN: cat %T/check-time-trace-events-pch.json \
+// RUN:   | %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   | FileCheck --check-prefix=PCH %s
+
+// RUN: %clangxx -S -O1 -fexperimental-new-pass-manager -ftime-trace -mllvm --time-trace-granularity=0 -o %T/check-time-trace-events-npm %s
+// RUN: cat %T/check-time-trace-events-npm.json \
+// RUN:   | %python -c 'import json, sys; json.dump(json.loads(sys.stdin.read()), sys.stdout, sort_keys=True, indent=2)' \
+// RUN:   | FileCheck --check-prefix=NPM %s
+
+// CHECK-DAG: "detail": "{{.*}}time-trace-header.h"
+// CHECK-DAG: "name": "Source"
+// CHECK-DAG: "detail": "main"
+// CHECK-DAG: "name": "ParseFunctionDefinition"
+// CHECK-DAG: "name": "InstantiateFunction"
+// CHECK-DAG: "name": "CodeGen Function"
+// CHECK-DAG: "name": "PerFunctionPasses"
+// CHECK-DAG: "name": "PerModulePasses"
+// CHECK-DAG: "name": "CodeGenPasses"
+
+// PCH-DAG: "detail": "{{.*}}check-time-trace-events.pch"
+// PCH-DAG: "name": "ReadAST"
+// PCH-DAG: "name": "InstantiateFunction"
+
+// NPM-DAG: "name": "Optimizer"
+// NPM-DAG: "name": "RunPass"
+// NPM-DAG: "name": "CodeGenPasses"
+
+#include "Inputs/time-trace-header.h"
+
+int main() {
+  return twice(1);
+}
@@ -0,0 +1,6 @@
+#ifndef HEADER_COST_A_H
+#define HEADER_COST_A_H
+#include "header-cost-b.h"
+int a1(void);
+int a2(void);
+#endif
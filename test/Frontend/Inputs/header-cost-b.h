@@ -0,0 +1,4 @@
+#pragma once
+struct B {
+  int X;
+};
@@ -0,0 +1,13 @@
+/* A license block,
+ * spanning lines. */
+#define ONE 1 // one
+#define TWO /* a comment that
+  spans lines */ 2
+#if 0
+#error not reached
+int disabled = ONE; // "quoted"
+#else
+int enabled = ONE; /* kept */
+#endif
+int two = TWO; int after = __LINE__;
+const char *str = "// not a comment";
@@ -0,0 +1 @@
+int used_func(void);
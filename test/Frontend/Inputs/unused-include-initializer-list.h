@@ -0,0 +1,9 @@
+namespace std {
+template <class E> class initializer_list {
+  const E *Begin;
+  decltype(sizeof(0)) Size;
+
+public:
+  constexpr initializer_list() : Begin(nullptr), Size(0) {}
+};
+}
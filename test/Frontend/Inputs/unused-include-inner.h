@@ -0,0 +1 @@
+int inner_func(void);
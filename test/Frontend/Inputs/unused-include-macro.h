@@ -0,0 +1 @@
+#define USED_MACRO 1
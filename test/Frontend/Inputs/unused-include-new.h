@@ -0,0 +1 @@
+void *operator new(decltype(sizeof(0)), void *) noexcept;
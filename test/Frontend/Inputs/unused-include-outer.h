@@ -0,0 +1 @@
+#include "unused-include-inner.h"
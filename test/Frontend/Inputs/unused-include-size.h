@@ -0,0 +1 @@
+typedef unsigned long size_type;
@@ -0,0 +1,4 @@
+#ifndef UNUSED_INCLUDE_TYPE_H
+#define UNUSED_INCLUDE_TYPE_H
+struct used_type { int x; };
+#endif
@@ -0,0 +1,6 @@
+namespace std {
+class type_info {
+public:
+  virtual ~type_info();
+};
+}
@@ -0,0 +1,2 @@
+typedef int unused_t;
+unused_t unused_func(void);
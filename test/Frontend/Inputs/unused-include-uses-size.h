@@ -0,0 +1,2 @@
+/* Relies on the includer to have declared size_type. */
+size_type size_of_thing(void);
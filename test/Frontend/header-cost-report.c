@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -header-cost-report %t.json %s
+// RUN: FileCheck %s < %t.json
+
+#include "header-cost-a.h"
+#include "header-cost-a.h"
+#include "header-cost-b.h"
+
+int main(void) { return a1() + a2(); }
+
+// CHECK:      "headers": [
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "decls": 2,
+// CHECK-NEXT:     "entered": 1,
+// CHECK-NEXT:     "file": "{{.*}}header-cost-a.h",
+// CHECK-NEXT:     "inclusive-decls": 4,
+// CHECK-NEXT:     "self-time-us": {{[0-9]+}},
+// CHECK-NEXT:     "skipped": 1,
+// CHECK-NEXT:     "time-us": {{[0-9]+}}
+// CHECK-NEXT:   },
+// CHECK-NEXT:   {
+// CHECK-NEXT:     "decls": 2,
+// CHECK-NEXT:     "entered": 1,
+// CHECK-NEXT:     "file": "{{.*}}header-cost-b.h",
+// CHECK-NEXT:     "inclusive-decls": 2,
+// CHECK-NEXT:     "self-time-us": {{[0-9]+}},
+// CHECK-NEXT:     "skipped": 1,
+// CHECK-NEXT:     "time-us": {{[0-9]+}}
+// CHECK-NEXT:   }
+// CHECK-NEXT: ],
+// CHECK-NEXT: "main-file": "{{.*}}header-cost-report.c"
@@ -0,0 +1,21 @@
+// REQUIRES: shell
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: echo '[{"directory": "%t", "file": "%s", "arguments": ["%clang", "-c", "-I", "%S/Inputs", "%s", "-o", "%t/out.o", "-MD", "-MF", "%t/out.d"]},' > %t/compile_commands.json
+// RUN: echo ' {"directory": "%t", "file": "%s", "arguments": ["%clang", "-c", "-I", "%S/Inputs", "%s", "-MMD", "-MT", "target"]}]' >> %t/compile_commands.json
+// RUN: %python %S/../../utils/merge-header-costs.py -p %t --json | FileCheck %s
+
+// The reports are produced without touching the outputs of the build.
+// RUN: ls %t | FileCheck --check-prefix=FILES %s
+
+#include "header-cost-a.h"
+
+int main(void) { return a1() + a2(); }
+
+// CHECK: "{{.*}}header-cost-a.h": {
+// CHECK: {{^  }}"units": 2
+
+// FILES-NOT: .o
+// FILES-NOT: .d
+// FILES: compile_commands.json
+// FILES-NOT: .o
+// FILES-NOT: .d
@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 -minimize-headers -fsyntax-only -verify -I %S/Inputs %s
+// RUN: %clang_cc1 -minimize-headers -E -C -I %S/Inputs %s | FileCheck %s
+// RUN: %clang_cc1 -E -C -I %S/Inputs %s | FileCheck -check-prefix=ORIGINAL %s
+// expected-no-diagnostics
+
+#include "minimize-headers.h"
+
+// Comments in the header are blanked out, but lines and columns stay the same.
+// CHECK: # 1 "{{.*}}minimize-headers.h" 1
+// CHECK-NOT: license
+// CHECK: int enabled = 1;{{ *$}}
+// CHECK: int two = 2; int after = 12;
+// CHECK-NEXT: const char *str = "// not a comment";
+
+// ORIGINAL: # 1 "{{.*}}minimize-headers.h" 1
+// ORIGINAL: A license block,
+// ORIGINAL: int enabled = 1; /* kept */
+
+int check_enabled = enabled + two;
+int check_after[after == 12 ? 1 : -1];
@@ -0,0 +1,15 @@
+// RUN: %clang_cc1 -fsyntax-only -std=c++11 -I %S/Inputs -Wunused-include \
+// RUN:   -verify %s
+
+// None of these headers is named in the code below, but the placement new,
+// the typeid and the deduced initializer list need them.
+#include "unused-include-new.h"
+#include "unused-include-typeinfo.h"
+#include "unused-include-initializer-list.h"
+#include "unused-include-unused.h" // expected-warning {{included header "unused-include-unused.h" is not used}}
+
+void construct(void *Buffer) { new (Buffer) int(0); }
+
+void identify() { (void)typeid(int); }
+
+void list() { auto List = {1, 2, 3}; (void)List; }
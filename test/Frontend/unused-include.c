@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -Wunused-include -verify %s
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -Wunused-include \
+// RUN:   -fdiagnostics-parseable-fixits %s 2>&1 | FileCheck %s -check-prefix=FIXIT
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs -unused-include-report %t.json %s
+// RUN: FileCheck %s -check-prefix=REPORT < %t.json
+
+#include "unused-include-func.h"
+#include "unused-include-macro.h"
+#include "unused-include-type.h"
+#include "unused-include-outer.h"
+#include "unused-include-unused.h" // expected-warning {{included header "unused-include-unused.h" is not used}}
+#include "unused-include-type.h"
+// Used by the next header only, which does not include it itself.
+#include "unused-include-size.h"
+#include "unused-include-uses-size.h"
+
+int main(void) {
+  struct used_type *p = 0;
+  return used_func() + inner_func() + USED_MACRO + (p != 0) +
+         (int)size_of_thing();
+}
+
+// FIXIT: fix-it:"{{.*}}unused-include.c":{11:1-12:1}:""
+// FIXIT-NOT: fix-it:
+
+// REPORT:      "main-file": "{{.*}}unused-include.c",
+// REPORT-NEXT: "unused-includes": [
+// REPORT-NEXT:   {
+// REPORT-NEXT:     "file": "{{.*}}unused-include-unused.h",
+// REPORT-NEXT:     "include": "\"unused-include-unused.h\"",
+// REPORT-NEXT:     "length": 113,
+// REPORT-NEXT:     "line": 11,
+// REPORT-NEXT:     "offset": {{[0-9]+}}
+// REPORT-NEXT:   }
+// REPORT-NEXT: ]
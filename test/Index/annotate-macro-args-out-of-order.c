@@ -0,0 +1,12 @@
+#define M1 1
+#define M2 2
+#define FM(x, y) y + x
+
+int v = FM(M1, M2);
+
+// M2 is expanded before M1, so the preprocessing record sees the two
+// expansions out of order.
+// RUN: c-index-test -test-annotate-tokens=%s:5:1:6:1 %s | FileCheck %s
+// CHECK: Identifier: "FM" [5:9 - 5:11] macro expansion=FM:3:9
+// CHECK: Identifier: "M1" [5:12 - 5:14] macro expansion=M1:1:9
+// CHECK: Identifier: "M2" [5:16 - 5:18] macro expansion=M2:2:9
@@ -0,0 +1,52 @@
+void shared(void) {
+  int s;
+  s = s + 1;
+}
+
+#ifdef FIRST
+void first(void) {
+  int x;
+  x = x + 1;
+}
+#else
+void second(void) {
+  int y;
+  y = y + 1;
+}
+#endif
+
+// RUN: rm -rf %t && mkdir %t
+// RUN: %clang -Wuninitialized -fsyntax-only -DFIRST %s --serialize-diagnostics %t/first.dia
+// RUN: %clang -Wuninitialized -fsyntax-only %s --serialize-diagnostics %t/second.dia
+// RUN: diagtool merge-serialized-diags -stats -j 2 -o %t/merged.dia %t/first.dia %t/second.dia | FileCheck -check-prefix=STATS %s
+// RUN: c-index-test -read-diagnostics %t/merged.dia 2>&1 | FileCheck -check-prefix=ALL %s
+// RUN: llvm-bcanalyzer -dump %t/merged.dia | FileCheck -check-prefix=LAYOUT %s
+// RUN: diagtool merge-serialized-diags -show-file %s %t/merged.dia | FileCheck -check-prefix=SHOW %s
+// RUN: diagtool merge-serialized-diags -show-file %s %t/first.dia | FileCheck -check-prefix=NOINDEX %s
+// RUN: diagtool merge-serialized-diags -show-file %t/none.c %t/merged.dia | count 0
+
+// STATS: 3 diagnostics, 1 duplicates removed
+
+// The index location block comes before the diagnostics, and the index after
+// them.
+// LAYOUT: <Meta
+// LAYOUT: <UnknownBlock11
+// LAYOUT: <Diag
+// LAYOUT-NOT: <UnknownBlock11
+// LAYOUT: <UnknownBlock10
+
+// ALL: {{.*[/\\]}}serialized-diags-merge.c:3:7: warning: variable 's' is uninitialized when used here [-Wuninitialized]
+// ALL: +-{{.*[/\\]}}serialized-diags-merge.c:2:8: note: initialize the variable 's' to silence this warning []
+// ALL: {{.*[/\\]}}serialized-diags-merge.c:9:7: warning: variable 'x' is uninitialized when used here [-Wuninitialized]
+// ALL: {{.*[/\\]}}serialized-diags-merge.c:14:7: warning: variable 'y' is uninitialized when used here [-Wuninitialized]
+// ALL: Number of diagnostics: 3
+
+// SHOW: serialized-diags-merge.c:3:7: warning: variable 's' is uninitialized when used here [-Wuninitialized]
+// SHOW-NEXT: serialized-diags-merge.c:2:8: note: initialize the variable 's' to silence this warning
+// SHOW-NEXT: serialized-diags-merge.c:9:7: warning: variable 'x' is uninitialized when used here [-Wuninitialized]
+// SHOW-NEXT: serialized-diags-merge.c:8:8: note: initialize the variable 'x' to silence this warning
+// SHOW-NEXT: serialized-diags-merge.c:14:7: warning: variable 'y' is uninitialized when used here [-Wuninitialized]
+
+// NOINDEX: serialized-diags-merge.c:3:7: warning: variable 's' is uninitialized
+// NOINDEX: serialized-diags-merge.c:9:7: warning: variable 'x' is uninitialized
+// NOINDEX-NOT: variable 'y'
@@ -0,0 +1,27 @@
+// REQUIRES: shell
+// The first compilation lexes the module map and stores its tokens in the
+// module cache. The second one is a separate process, which parses the module
+// map from the stored tokens.
+
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/module-map-token-cache -fsyntax-only -print-stats %s \
+// RUN:   2>&1 | FileCheck --check-prefix=FIRST %s
+// RUN: ls %t/modulemap-tokens | FileCheck --check-prefix=FILES %s
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/module-map-token-cache -fsyntax-only -print-stats %s \
+// RUN:   2>&1 | FileCheck --check-prefix=SECOND %s
+
+// A damaged token file is ignored.
+// RUN: for f in %t/modulemap-tokens/*.tokens; do echo broken > $f; done
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -I %S/Inputs/module-map-token-cache -fsyntax-only -print-stats %s \
+// RUN:   2>&1 | FileCheck --check-prefix=FIRST %s
+
+// FIRST: {{[0-9]+}} module map files parsed, 0 without lexing.
+// FILES: {{.*}}.tokens
+// SECOND: [[N:[0-9]+]] module map files parsed, [[N]] without lexing.
+
+#include "a.h"
+
+int c = a;
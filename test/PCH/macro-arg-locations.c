@@ -0,0 +1,20 @@
+// Test that the locations of macro arguments survive a round trip through a
+// PCH file.
+
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -verify %s
+
+#ifndef HEADER
+#define HEADER
+
+#define ID(x) x
+#define DECLARE(type, name) ID(type) ID(name)
+
+DECLARE(int, x);
+
+#else
+
+float x; // expected-error {{redefinition of 'x' with a different type: 'float' vs 'int'}}
+// expected-note@13 {{previous definition is here}}
+
+#endif
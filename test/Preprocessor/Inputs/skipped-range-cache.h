@@ -0,0 +1,10 @@
+#if 0
+#if NESTED
+#else
+#endif
+int not_declared;
+#elif 0
+int not_declared_either;
+#else
+extern int declared;
+#endif
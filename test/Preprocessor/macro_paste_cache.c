@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -E -print-stats %s 2>&1 | FileCheck %s
+
+#define CAT(a, b) a ## b
+
+// CHECK: foobar foobar foobar
+CAT(foo, bar) CAT(foo, bar) CAT(foo, bar)
+
+// CHECK: 12 12 1.5
+CAT(1, 2) CAT(1, 2) CAT(1., 5)
+
+// CHECK: 6 token paste (##) operations performed, 3 on the fast path, 3 reusing an earlier result.
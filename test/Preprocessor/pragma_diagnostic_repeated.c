@@ -0,0 +1,64 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -Wunused-variable -Wunused-label %s
+
+// Identical diagnostic pragmas share the state they produce. Check that the
+// shared states still depend on the state each pragma was applied to, and on
+// the exact group that the pragma names.
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmultichar"
+int a1 = 'ab';
+#pragma clang diagnostic pop
+
+int a2 = 'ab'; // expected-warning {{multi-character character constant}}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmultichar"
+int a3 = 'ab';
+#pragma clang diagnostic pop
+
+int a4 = 'ab'; // expected-warning {{multi-character character constant}}
+
+#pragma clang diagnostic error "-Wmultichar"
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wmultichar"
+int a5 = 'ab';
+#pragma clang diagnostic pop
+
+int a6 = 'ab'; // expected-error {{multi-character character constant}}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic warning "-Wmultichar"
+int a7 = 'ab'; // expected-warning {{multi-character character constant}}
+#pragma clang diagnostic pop
+
+#pragma clang diagnostic warning "-Wmultichar"
+
+void f1(void) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused"
+  int x;
+l1:;
+#pragma clang diagnostic pop
+}
+
+void f2(void) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-variable"
+  int x;
+l2:; // expected-warning {{unused label 'l2'}}
+#pragma clang diagnostic pop
+}
+
+void f3(void) {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused"
+  int x;
+l3:;
+#pragma clang diagnostic pop
+}
+
+void f4(void) {
+  int x; // expected-warning {{unused variable 'x'}}
+l4:; // expected-warning {{unused label 'l4'}}
+}
@@ -0,0 +1,19 @@
+// RUN: %clang_cc1 -E -P %s | FileCheck -strict-whitespace %s
+// RUN: %clang_cc1 -E -P -trigraphs %s | FileCheck -strict-whitespace -check-prefix=TRIGRAPH %s
+
+// Punctuators are printed as they are spelled, except that escaped newlines
+// and trigraphs are cleaned out of them.
+
+#define CAT(a, b) a ## b
+
+int a<:2:> = <% 1, 2 %>;
+// CHECK: int a<:2:> = <% 1, 2 %>;
+x += y >>= z -> w ... v;
+// CHECK: x += y >>= z -> w ... v;
+p <<\
+= q;
+// CHECK: p <<= q;
+CAT(-, =) CAT(<, <)
+// CHECK: -= <<
+x ??< y ??> z;
+// TRIGRAPH: x { y } z;
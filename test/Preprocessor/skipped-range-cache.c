@@ -0,0 +1,11 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -print-stats %s 2>&1 | FileCheck %s
+// expected-no-diagnostics
+
+// The second inclusion skips over the blocks found by the first one, without
+// lexing them.
+#include "Inputs/skipped-range-cache.h"
+#include "Inputs/skipped-range-cache.h"
+
+int use = declared;
+
+// CHECK: 2 #if/#ifndef#ifdef regions skipped, 2 blocks skipped without lexing.
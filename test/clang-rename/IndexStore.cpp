@@ -0,0 +1,21 @@
+#define moo foo           // CHECK: #define moo bar
+
+int foo() /* Test 1 */ {  // CHECK: int bar() /* Test 1 */ {
+  return 42;
+}
+
+void boo(int value) {}
+
+void qoo() {
+  foo();                  // CHECK: bar();
+  boo(foo());             // CHECK: boo(bar());
+  moo();
+  boo(moo());
+}
+
+// The references inside the macro expansions are not spelled where the index
+// records them, so this file is parsed to rename the macro definition.
+// RUN: rm -rf %t.idx
+// RUN: %clang_cc1 -fsyntax-only -index-store-path %t.idx %s
+// RUN: clang-rename -qualified-name=foo -new-name=bar -index-store=%t.idx %s -- | sed 's,//.*,,' | FileCheck %s
+// RUN: clang-rename -qualified-name=foo -new-name=bar -index-store=%t.idx -j=1 %s -- | sed 's,//.*,,' | FileCheck %s
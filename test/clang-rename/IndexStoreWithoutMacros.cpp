@@ -0,0 +1,18 @@
+int foo() /* Test 1 */ {  // CHECK: int bar() /* Test 1 */ {
+  return 42;
+}
+
+void boo(int value) {}
+
+void qoo() {
+  foo();                  // CHECK: bar();
+  boo(foo());             // CHECK: boo(bar());
+}
+
+// Every occurrence is spelled where the index records it, so the edits come
+// from the index store alone. The compile command turns the unused parameter
+// into an error, which makes clang-rename fail if it parses the file to
+// rename it.
+// RUN: rm -rf %t.idx
+// RUN: %clang_cc1 -fsyntax-only -index-store-path %t.idx %s
+// RUN: clang-rename -qualified-name=foo -new-name=bar -index-store=%t.idx %s -- -Wunused-parameter -Werror | sed 's,//.*,,' | FileCheck %s
@@ -23,6 +23,7 @@
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Refactoring.h"
+#include "clang/Tooling/Refactoring/Rename/IndexedRename.h"
 #include "clang/Tooling/Refactoring/Rename/RenamingAction.h"
 #include "clang/Tooling/Refactoring/Rename/USRFindingAction.h"
 #include "clang/Tooling/ReplacementsYaml.h"
@@ -30,8 +31,13 @@
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
+#include <set>
 #include <string>
 #include <system_error>
 
@@ -96,6 +102,93 @@ static cl::opt<std::string>
 static cl::opt<bool> Force("force",
                            cl::desc("Ignore nonexistent qualified names."),
                            cl::cat(ClangRenameOptions));
+static cl::opt<std::string> IndexStore(
+    "index-store",
+    cl::desc("Find the occurrences to rename in the index store at <path>, "
+             "and only parse the translation units it cannot account for."),
+    cl::value_desc("path"), cl::cat(ClangRenameOptions));
+static cl::opt<unsigned>
+    Threads("j",
+            cl::desc("Number of translation units to parse in parallel with "
+                     "-index-store (default: one per hardware thread)."),
+            cl::init(0), cl::cat(ClangRenameOptions));
+
+/// Renames the symbols using the index store, parsing only the files whose
+/// occurrences the index cannot account for, and adds the resulting
+/// replacements to \p FileToReplaces.
+static int renameWithIndexStore(
+    const tooling::CompilationDatabase &Compilations,
+    ArrayRef<std::string> Files, const std::vector<std::string> &NewNames,
+    const std::vector<std::string> &PrevNames,
+    const std::vector<std::vector<std::string>> &USRList,
+    std::map<std::string, tooling::Replacements> &FileToReplaces) {
+  Expected<tooling::IndexedRenameEdits> Edits = tooling::findIndexedRenameEdits(
+      IndexStore, NewNames, PrevNames, USRList, PrintLocations);
+  if (!Edits) {
+    errs() << "clang-rename: " << toString(Edits.takeError()) << "\n";
+    return 1;
+  }
+
+  // Files that the index knows nothing about are renamed by parsing them.
+  std::vector<std::string> FilesToParse = Edits->FilesToReparse;
+  for (const std::string &File : Files) {
+    SmallString<128> AbsolutePath(File);
+    sys::fs::make_absolute(AbsolutePath);
+    if (!Edits->IndexedFiles.count(AbsolutePath) &&
+        !llvm::is_contained(FilesToParse, AbsolutePath.str()))
+      FilesToParse.push_back(AbsolutePath.str().str());
+  }
+
+  // The parsed files report the occurrences that the index already found
+  // again, so only keep the ones that are new.
+  std::set<std::pair<std::string, unsigned>> Renamed;
+  auto AddReplacement = [&](const tooling::Replacement &Replace) {
+    if (!Renamed.insert({Replace.getFilePath(), Replace.getOffset()}).second)
+      return true;
+    if (auto Err = FileToReplaces[Replace.getFilePath()].add(Replace)) {
+      errs() << "clang-rename: " << toString(std::move(Err)) << "\n";
+      return false;
+    }
+    return true;
+  };
+
+  int ExitCode = 0;
+  for (const auto &Entry : Edits->FileToReplaces)
+    for (const tooling::Replacement &Replace : Entry.second)
+      if (!AddReplacement(Replace))
+        ExitCode = 1;
+
+  std::mutex Mutex;
+  {
+    ThreadPool Pool(Threads == 0 ? hardware_concurrency() : Threads);
+    for (const std::string &File : FilesToParse) {
+      Pool.async([&, File] {
+        // Each thread gets its own file system so that the translation units
+        // can use different working directories.
+        IntrusiveRefCntPtr<vfs::FileSystem> FS =
+            vfs::createPhysicalFileSystem().release();
+        tooling::ClangTool Tool(Compilations, File,
+                                std::make_shared<PCHContainerOperations>(),
+                                FS);
+        std::map<std::string, tooling::Replacements> Replaces;
+        tooling::RenamingAction RenameAction(NewNames, PrevNames, USRList,
+                                             Replaces, PrintLocations);
+        int Result =
+            Tool.run(tooling::newFrontendActionFactory(&RenameAction).get());
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (Result)
+          ExitCode = Result;
+        for (const auto &Entry : Replaces)
+          for (const tooling::Replacement &Replace : Entry.second)
+            if (!AddReplacement(Replace))
+              ExitCode = 1;
+      });
+    }
+    Pool.wait();
+  }
+  return ExitCode;
+}
 
 int main(int argc, const char **argv) {
   tooling::CommonOptionsParser OP(argc, argv, ClangRenameOptions);
@@ -181,10 +274,30 @@ int main(int argc, const char **argv) {
       tooling::newFrontendActionFactory(&RenameAction);
   int ExitCode;
 
-  if (Inplace) {
+  if (!IndexStore.empty()) {
+    ExitCode = renameWithIndexStore(OP.getCompilations(), Files, NewNames,
+                                    PrevNames, USRList, Tool.getReplacements());
+    if (ExitCode)
+      return ExitCode;
+  }
+
+  if (Inplace && IndexStore.empty()) {
     ExitCode = Tool.runAndSave(Factory.get());
+  } else if (Inplace) {
+    LangOptions DefaultLangOptions;
+    IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+    TextDiagnosticPrinter DiagnosticPrinter(errs(), &*DiagOpts);
+    DiagnosticsEngine Diagnostics(
+        IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs()), &*DiagOpts,
+        &DiagnosticPrinter, false);
+    SourceManager Sources(Diagnostics, Tool.getFiles());
+    Rewriter Rewrite(Sources, DefaultLangOptions);
+    if (!Tool.applyAllReplacements(Rewrite))
+      errs() << "Skipped some replacements.\n";
+    ExitCode = Rewrite.overwriteChangedFiles() ? 1 : 0;
   } else {
-    ExitCode = Tool.run(Factory.get());
+    if (IndexStore.empty())
+      ExitCode = Tool.run(Factory.get());
 
     if (!ExportFixes.empty()) {
       std::error_code EC;
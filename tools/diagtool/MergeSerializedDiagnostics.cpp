@@ -0,0 +1,121 @@
+//===- MergeSerializedDiagnostics.cpp - diagtool tool for merging .dia ----===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "DiagTool.h"
+#include "clang/Frontend/SerializedDiagnosticIndex.h"
+#include "clang/Frontend/SerializedDiagnostics.h"
+#include "llvm/Support/CommandLine.h"
+
+DEF_DIAGTOOL("merge-serialized-diags",
+             "Merge serialized diagnostics files into one indexed file",
+             MergeSerializedDiagnostics)
+
+using namespace clang;
+using namespace clang::serialized_diags;
+
+static StringRef getSeverityName(unsigned Severity) {
+  switch (Severity) {
+  case Ignored: return "ignored";
+  case Note:    return "note";
+  case Warning: return "warning";
+  case Error:   return "error";
+  case Fatal:   return "fatal error";
+  case Remark:  return "remark";
+  }
+  return "unknown";
+}
+
+static void printDiagnostic(const LoadedDiagnostic &D, llvm::raw_ostream &OS,
+                            unsigned Indent = 0) {
+  OS.indent(Indent);
+  if (!D.Loc.Filename.empty())
+    OS << D.Loc.Filename << ':' << D.Loc.Line << ':' << D.Loc.Col << ": ";
+  OS << getSeverityName(D.Severity) << ": " << D.Message;
+  if (!D.Flag.empty())
+    OS << " [" << D.Flag << ']';
+  OS << '\n';
+  for (const LoadedDiagnostic &Child : D.Children)
+    printDiagnostic(Child, OS, Indent + 2);
+}
+
+int MergeSerializedDiagnostics::run(unsigned int argc, char **argv,
+                                    llvm::raw_ostream &OS) {
+  static llvm::cl::OptionCategory MergeOptions(
+      "diagtool merge-serialized-diags options");
+
+  static llvm::cl::list<std::string> Inputs(
+      llvm::cl::Positional, llvm::cl::desc("<input .dia files>"),
+      llvm::cl::cat(MergeOptions));
+
+  static llvm::cl::opt<std::string> Output(
+      "o", llvm::cl::desc("Write the merged diagnostics to <file>"),
+      llvm::cl::value_desc("file"), llvm::cl::cat(MergeOptions));
+
+  static llvm::cl::opt<unsigned> Threads(
+      "j", llvm::cl::desc("Number of threads to read inputs on (default: one "
+                          "per hardware thread)"),
+      llvm::cl::init(0), llvm::cl::cat(MergeOptions));
+
+  static llvm::cl::opt<std::string> ShowFile(
+      "show-file",
+      llvm::cl::desc("Instead of merging, print the diagnostics located in "
+                     "<source> from the single input, using its index"),
+      llvm::cl::value_desc("source"), llvm::cl::cat(MergeOptions));
+
+  static llvm::cl::opt<bool> Stats(
+      "stats", llvm::cl::desc("Print the number of merged diagnostics"),
+      llvm::cl::cat(MergeOptions));
+
+  std::vector<const char *> Args;
+  Args.push_back("diagtool merge-serialized-diags");
+  for (const char *A : llvm::makeArrayRef(argv, argc))
+    Args.push_back(A);
+
+  llvm::cl::HideUnrelatedOptions(MergeOptions);
+  llvm::cl::ParseCommandLineOptions((int)Args.size(), Args.data(),
+                                    "Serialized diagnostics merging utility");
+
+  if (!ShowFile.empty()) {
+    if (Inputs.size() != 1) {
+      llvm::errs() << "error: -show-file requires exactly one input\n";
+      return 1;
+    }
+    llvm::ErrorOr<std::vector<LoadedDiagnostic>> Diags =
+        loadDiagnosticsForFile(Inputs.front(), ShowFile);
+    if (!Diags) {
+      llvm::errs() << "error: " << Inputs.front() << ": "
+                   << Diags.getError().message() << '\n';
+      return 1;
+    }
+    for (const LoadedDiagnostic &D : *Diags)
+      printDiagnostic(D, OS);
+    return 0;
+  }
+
+  if (Output.empty()) {
+    llvm::errs() << "error: no output file specified\n";
+    return 1;
+  }
+
+  llvm::Expected<MergedDiagnostics> Merged =
+      MergedDiagnostics::create(Inputs, Threads);
+  if (!Merged) {
+    llvm::errs() << "error: " << llvm::toString(Merged.takeError()) << '\n';
+    return 1;
+  }
+
+  if (std::error_code EC = Merged->write(Output)) {
+    llvm::errs() << "error: " << Output << ": " << EC.message() << '\n';
+    return 1;
+  }
+
+  if (Stats)
+    OS << Merged->diagnostics().size() << " diagnostics, "
+       << Merged->getNumDuplicates() << " duplicates removed\n";
+  return 0;
+}
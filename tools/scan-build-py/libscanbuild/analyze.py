@@ -23,6 +23,7 @@ import contextlib
 import datetime
 import shutil
 import glob
+import hashlib
 from collections import defaultdict
 
 from libscanbuild import command_entry_point, compiler_wrapper, \
@@ -30,6 +31,7 @@ from libscanbuild import command_entry_point, compiler_wrapper, \
 from libscanbuild.arguments import parse_args_for_scan_build, \
     parse_args_for_analyze_build
 from libscanbuild.intercept import capture
+from libscanbuild.jobserver import get_job_server, limit_jobs
 from libscanbuild.report import document
 from libscanbuild.compilation import split_command, classify_source, \
     compiler_language
@@ -211,6 +213,9 @@ def run_analyzer_parallel(args):
         return any(re.match(r'^' + directory, filename)
                    for directory in args.excludes)
 
+    ctu = get_ctu_config_from_args(args)
+    # The results of a CTU analysis depend on the other translation units.
+    cache_dir = None if ctu.analyze else args.cache_dir
     consts = {
         'clang': args.clang,
         'output_dir': args.output,
@@ -218,22 +223,36 @@ def run_analyzer_parallel(args):
         'output_failures': args.output_failures,
         'direct_args': analyzer_params(args),
         'force_debug': args.force_debug,
-        'ctu': get_ctu_config_from_args(args)
+        'ctu': ctu,
+        'cache_dir': cache_dir,
+        # asked once here, instead of for every translation unit
+        'clang_version': get_version(args.clang) if cache_dir else None
     }
 
     logging.debug('run analyzer against compilation database')
     with open(args.cdb, 'r') as handle:
         generator = (dict(cmd, **consts)
                      for cmd in json.load(handle) if not exclude(cmd['file']))
+        # when run from make, take the job slots from its job server
+        job_server = get_job_server()
         # when verbose output requested execute sequentially
         pool = multiprocessing.Pool(1 if args.verbose > 2 else None)
-        for current in pool.imap_unordered(run, generator):
-            if current is not None:
-                # display error message from the static analyzer
-                for line in current['error_output']:
-                    logging.info(line.rstrip())
-        pool.close()
-        pool.join()
+        try:
+            for current in pool.imap_unordered(
+                    run, limit_jobs(job_server, generator)):
+                if job_server is not None:
+                    job_server.release()
+                if current is not None:
+                    # display error message from the static analyzer
+                    for line in current['error_output']:
+                        logging.info(line.rstrip())
+        finally:
+            # give back the tokens of the runs abandoned by an error, before
+            # stopping the pool waits for the jobs still being handed out
+            if job_server is not None:
+                job_server.close()
+            pool.terminate()
+            pool.join()
 
 
 def govern_analyzer_runs(args):
@@ -282,7 +301,11 @@ def setup_environment(args):
         'ANALYZE_BUILD_REPORT_FAILURES': 'yes' if args.output_failures else '',
         'ANALYZE_BUILD_PARAMETERS': ' '.join(analyzer_params(args)),
         'ANALYZE_BUILD_FORCE_DEBUG': 'yes' if args.force_debug else '',
-        'ANALYZE_BUILD_CTU': json.dumps(get_ctu_config_from_args(args))
+        'ANALYZE_BUILD_CTU': json.dumps(get_ctu_config_from_args(args)),
+        'ANALYZE_BUILD_CACHE_DIR': args.cache_dir or '',
+        'ANALYZE_BUILD_CLANG_VERSION':
+            get_version(args.clang)
+            if args.cache_dir and need_analyzer(args.build) else ''
     })
     return environment
 
@@ -316,7 +339,9 @@ def analyze_compiler_wrapper_impl(result, execution):
         'force_debug': os.getenv('ANALYZE_BUILD_FORCE_DEBUG'),
         'directory': execution.cwd,
         'command': [execution.cmd[0], '-c'] + compilation.flags,
-        'ctu': get_ctu_config_from_json(os.getenv('ANALYZE_BUILD_CTU'))
+        'ctu': get_ctu_config_from_json(os.getenv('ANALYZE_BUILD_CTU')),
+        'cache_dir': os.getenv('ANALYZE_BUILD_CACHE_DIR'),
+        'clang_version': os.getenv('ANALYZE_BUILD_CLANG_VERSION')
     }
     # call static analyzer against the compilation
     for source in compilation.files:
@@ -513,9 +538,10 @@ def report_failure(opts):
 def run_analyzer(opts, continuation=report_failure):
     """ It assembles the analysis command line and executes it. Capture the
     output of the analysis and returns with it. If failure reports are
-    requested, it calls the continuation to generate it. """
+    requested, it calls the continuation to generate it. If a result cache
+    is given, the analysis goes through it. """
 
-    def target():
+    def target(output_dir):
         """ Creates output file name for reports. """
         if opts['output_format'] in {
                 'plist',
@@ -523,18 +549,26 @@ def run_analyzer(opts, continuation=report_failure):
                 'plist-multi-file'}:
             (handle, name) = tempfile.mkstemp(prefix='report-',
                                               suffix='.plist',
-                                              dir=opts['output_dir'])
+                                              dir=output_dir)
             os.close(handle)
             return name
-        return opts['output_dir']
+        return output_dir
 
-    try:
+    def analyze(output_dir):
+        """ Runs the analyzer with the reports going to the given directory.
+        """
         cwd = opts['directory']
         cmd = get_arguments([opts['clang'], '--analyze'] +
                             opts['direct_args'] + opts['flags'] +
-                            [opts['file'], '-o', target()],
+                            [opts['file'], '-o', target(output_dir)],
                             cwd)
-        output = run_command(cmd, cwd=cwd)
+        return run_command(cmd, cwd=cwd)
+
+    try:
+        if opts.get('cache_dir'):
+            output = run_analyzer_cached(opts, analyze)
+        else:
+            output = analyze(opts['output_dir'])
         return {'error_output': output, 'exit_code': 0}
     except subprocess.CalledProcessError as ex:
         result = {'error_output': ex.output, 'exit_code': ex.returncode}
@@ -544,6 +578,93 @@ def run_analyzer(opts, continuation=report_failure):
         return result
 
 
+@require(['clang', 'directory', 'flags', 'direct_args', 'file', 'output_dir',
+          'output_format', 'cache_dir'])
+def run_analyzer_cached(opts, analyze):
+    """ Runs the analysis through the result cache.
+
+    The cache is keyed by the preprocessed source together with the analyzer
+    and its arguments. When an earlier run analyzed the same input, its
+    reports are copied into the output directory instead of analyzing the
+    translation unit again. Otherwise the analysis runs into a staging
+    directory, and its reports are stored in the cache before they are moved
+    into the output directory. Failed analyses are not cached. """
+
+    try:
+        key = analysis_key(opts)
+    except subprocess.CalledProcessError:
+        # Leave it to the analyzer to report the problem.
+        return analyze(opts['output_dir'])
+
+    entry = os.path.join(opts['cache_dir'], key[:2], key)
+    if os.path.isdir(entry):
+        logging.debug("reuse cached analysis of '%s'", opts['file'])
+        with open(os.path.join(entry, 'output.json'), 'r') as handle:
+            output = json.load(handle)
+        reports = os.path.join(entry, 'reports')
+        for name in os.listdir(reports):
+            shutil.copy(os.path.join(reports, name), opts['output_dir'])
+        return output
+
+    staging = tempfile.mkdtemp(prefix='analysis-', dir=opts['output_dir'])
+    try:
+        output = analyze(staging)
+        store_analysis(entry, staging, output)
+        return output
+    finally:
+        # Keep the reports even if the analyzer failed halfway.
+        for name in os.listdir(staging):
+            shutil.move(os.path.join(staging, name), opts['output_dir'])
+        shutil.rmtree(staging, ignore_errors=True)
+
+
+@require(['clang', 'directory', 'flags', 'direct_args', 'file',
+          'output_format'])
+def analysis_key(opts):
+    """ Returns the key of an analysis in the result cache: the hash of the
+    preprocessed source, the analyzer version and the analysis arguments.
+
+    The source is preprocessed the way the analyzer sees it, which defines
+    the '__clang_analyzer__' macro. The version is taken from the
+    'clang_version' option when the caller already asked for it. """
+
+    with open(os.devnull, 'w') as devnull:
+        preprocessed = subprocess.check_output(
+            [opts['clang'], '-E', '-D__clang_analyzer__'] + opts['flags'] +
+            [opts['file']],
+            cwd=opts['directory'], stderr=devnull)
+
+    version = opts.get('clang_version') or get_version(opts['clang'])
+    arguments = [version, opts['output_format'],
+                 opts['file']] + opts['direct_args'] + opts['flags']
+    digest = hashlib.sha256(preprocessed)
+    digest.update(json.dumps(arguments).encode('utf-8'))
+    return digest.hexdigest()
+
+
+def store_analysis(entry, reports_dir, output):
+    """ Stores the reports of an analysis and its output in the result cache.
+
+    The entry is put together in a temporary directory and then renamed, so
+    that concurrent runs never see it half-written. """
+
+    parent = os.path.dirname(entry)
+    try:
+        os.makedirs(parent)
+    except OSError:
+        # In case an other process already created it.
+        pass
+    staging = tempfile.mkdtemp(prefix='tmp-', dir=parent)
+    try:
+        shutil.copytree(reports_dir, os.path.join(staging, 'reports'))
+        with open(os.path.join(staging, 'output.json'), 'w') as handle:
+            json.dump(output, handle)
+        os.rename(staging, entry)
+    except OSError:
+        # In case an other process stored the same analysis.
+        shutil.rmtree(staging, ignore_errors=True)
+
+
 def extdef_map_list_src_to_ast(extdef_src_list):
     """ Turns textual external definition map list with source files into an
     external definition map list with ast files. """
@@ -98,6 +98,10 @@ def normalize_args_for_analyze(args, from_build_command):
         # add cdb parameter invisibly to make report module working.
         args.cdb = 'compile_commands.json'
 
+    # the cache directory is used from other working directories.
+    if args.cache_dir:
+        args.cache_dir = os.path.abspath(args.cache_dir)
+
     # Make ctu_dir an abspath as it is needed inside clang
     if not from_build_command and hasattr(args, 'ctu_phases') \
             and hasattr(args.ctu_phases, 'dir'):
@@ -317,6 +321,14 @@ def create_analyze_parser(from_build_command):
         Switch the page naming to:
         report-<filename>-<function/method name>-<id>.html
         instead of report-XXXXXX.html""")
+    advanced.add_argument(
+        '--cache-dir',
+        metavar='<path>',
+        dest='cache_dir',
+        help="""Store the reports of each translation unit in this directory,
+        and reuse them in later runs instead of analyzing the translation
+        units again whose preprocessed source, analyzer and analyzer options
+        did not change. The directory is never cleaned up.""")
     advanced.add_argument(
         '--force-analyze-debug-code',
         dest='force_debug',
@@ -0,0 +1,164 @@
+# -*- coding: utf-8 -*-
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+""" This module implements a client of the GNU make job server.
+
+When analyze-build runs from a make recipe (marked with '+', or one that
+refers to $(MAKE)), make passes it a pipe of job tokens in MAKEFLAGS. Every
+job beyond the first one needs a token from that pipe, which is handed back
+once the job is done. So the analyzer runs share the parallelism given to
+the outermost make with everything else it runs, instead of adding to it. """
+
+import fcntl
+import os
+import re
+import select
+import threading
+
+__all__ = ['get_job_server', 'limit_jobs']
+
+# How long to wait for a token before looking whether a job has finished.
+POLL_INTERVAL = 0.1
+
+
+class JobServer(object):
+    """ Hands out the job slots of a GNU make job server.
+
+    A process holds one slot implicitly, which is used first. The others are
+    taken from the job server as tokens. """
+
+    def __init__(self, read_fd, write_fd):
+        self.read_fd = read_fd
+        self.write_fd = write_fd
+        self.lock = threading.Lock()
+        self.implicit_slot_free = True
+        self.tokens = []
+        self.closed = False
+
+    def acquire(self):
+        """ Waits for a job slot. Returns at once after close. """
+
+        while True:
+            with self.lock:
+                if self.closed:
+                    return
+                if self.implicit_slot_free:
+                    self.implicit_slot_free = False
+                    return
+            # Don't block on the pipe, because the implicit slot may be
+            # freed by a finished job in the meantime.
+            readable, _, _ = select.select([self.read_fd], [], [],
+                                           POLL_INTERVAL)
+            if readable:
+                # When another client took the token first, the read fails
+                # if the pipe is non-blocking, and waits for the next token
+                # if it could not be made so.
+                try:
+                    token = os.read(self.read_fd, 1)
+                except OSError:
+                    continue
+                if token:
+                    with self.lock:
+                        if self.closed:
+                            os.write(self.write_fd, token)
+                        else:
+                            self.tokens.append(token)
+                    return
+
+    def release(self):
+        """ Gives back the slot of a finished job. """
+
+        with self.lock:
+            if self.tokens:
+                os.write(self.write_fd, self.tokens.pop())
+            else:
+                self.implicit_slot_free = True
+
+    def close(self):
+        """ Gives back the tokens of the jobs that are still running, and
+        stops waiting for slots. Used when the jobs are abandoned. """
+
+        with self.lock:
+            self.closed = True
+            while self.tokens:
+                os.write(self.write_fd, self.tokens.pop())
+
+
+def parse_job_server_auth(makeflags):
+    """ Finds the job server in the value of MAKEFLAGS.
+
+    :param makeflags: the value of MAKEFLAGS
+    :return: a pair of file descriptors, a named pipe path, or None """
+
+    match = None
+    for match in re.finditer(r'--jobserver-(?:auth|fds)=(\S+)', makeflags):
+        pass
+    if match is None:
+        return None
+    auth = match.group(1)
+    if auth.startswith('fifo:'):
+        return auth[len('fifo:'):]
+    fds = re.match(r'^(\d+),(\d+)$', auth)
+    if fds:
+        return int(fds.group(1)), int(fds.group(2))
+    return None
+
+
+def get_job_server(environment=None):
+    """ Connects to the job server of the make that runs us, if there is one
+    and it passed its pipe down to us.
+
+    :param environment: the environment to look for MAKEFLAGS in
+    :return: a JobServer or None """
+
+    environment = os.environ if environment is None else environment
+    auth = parse_job_server_auth(environment.get('MAKEFLAGS', ''))
+    if auth is None:
+        return None
+    if isinstance(auth, tuple):
+        try:
+            for fd in auth:
+                os.fstat(fd)
+        except OSError:
+            # The recipe was not marked as recursive, so the pipe is closed.
+            return None
+        return JobServer(open_non_blocking(auth[0]), auth[1])
+    try:
+        read_fd = os.open(auth, os.O_RDONLY | os.O_NONBLOCK)
+        write_fd = os.open(auth, os.O_WRONLY)
+    except OSError:
+        return None
+    return JobServer(read_fd, write_fd)
+
+
+def open_non_blocking(read_fd):
+    """ Opens the read end of the job server pipe again, in non-blocking
+    mode.
+
+    Making the inherited descriptor non-blocking would change it for make and
+    its other clients too, which share it. Opening the pipe through /proc
+    gives a descriptor of our own. Where that is not possible, the inherited
+    one is returned unchanged.
+
+    :param read_fd: the inherited read end of the pipe
+    :return: a file descriptor to read the tokens from """
+
+    try:
+        fd = os.open('/proc/self/fd/{0}'.format(read_fd),
+                     os.O_RDONLY | os.O_NONBLOCK)
+    except OSError:
+        return read_fd
+    fcntl.fcntl(fd, fcntl.F_SETFD, fcntl.FD_CLOEXEC)
+    return fd
+
+
+def limit_jobs(job_server, jobs):
+    """ Yields the jobs one by one, each once a job slot is free for it.
+
+    The caller has to release the slot of every job that finished. """
+
+    for job in jobs:
+        if job_server is not None:
+            job_server.acquire()
+        yield job
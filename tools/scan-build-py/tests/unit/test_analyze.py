@@ -167,6 +167,56 @@ class RunAnalyzerTest(unittest.TestCase):
         self.assertTrue(len(fwds['error_output']) > 0)
 
 
+class RunAnalyzerCachedTest(unittest.TestCase):
+
+    def run_analyses(self, contents, clang_version=None):
+        """ Analyzes a file through the cache once for each of the contents,
+        and returns the number of analyses that were not taken from it. """
+
+        with libear.TemporaryDirectory() as tmpdir:
+            filename = os.path.join(tmpdir, 'test.c')
+            calls = []
+
+            def analyze(output_dir):
+                calls.append(output_dir)
+                report = os.path.join(output_dir, 'report-test.html')
+                with open(report, 'w') as handle:
+                    handle.write('report')
+                return ['warning']
+
+            for index, content in enumerate(contents):
+                with open(filename, 'w') as handle:
+                    handle.write(content)
+                output_dir = os.path.join(tmpdir, str(index))
+                os.mkdir(output_dir)
+                opts = {
+                    'clang': 'clang',
+                    'clang_version': clang_version,
+                    'directory': tmpdir,
+                    'flags': [],
+                    'direct_args': [],
+                    'file': filename,
+                    'output_dir': output_dir,
+                    'output_format': 'html',
+                    'cache_dir': os.path.join(tmpdir, 'cache')
+                }
+                output = sut.run_analyzer_cached(opts, analyze)
+                self.assertEqual(['warning'], output)
+                self.assertEqual(['report-test.html'], os.listdir(output_dir))
+            return len(calls)
+
+    def test_reports_reused_until_source_changes(self):
+        self.assertEqual(1, self.run_analyses(['int f() { return 0; }',
+                                               'int f() { return 0; }']))
+        self.assertEqual(2, self.run_analyses(['int f() { return 0; }',
+                                               'int f() { return 0; }',
+                                               'int f() { return 1; }']))
+
+    def test_analyzer_only_code_changes(self):
+        guarded = '#ifdef __clang_analyzer__\nint f() { return %d; }\n#endif\n'
+        self.assertEqual(2, self.run_analyses([guarded % 0, guarded % 1]))
+
+
 class ReportFailureTest(unittest.TestCase):
 
     def assertUnderFailures(self, path):
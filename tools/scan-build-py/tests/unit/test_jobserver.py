@@ -0,0 +1,100 @@
+# -*- coding: utf-8 -*-
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+import fcntl
+import os
+import unittest
+import libscanbuild.jobserver as sut
+
+
+class ParseJobServerAuthTest(unittest.TestCase):
+
+    def test_no_job_server(self):
+        self.assertIsNone(sut.parse_job_server_auth(''))
+        self.assertIsNone(sut.parse_job_server_auth('-j4 -- CC=clang'))
+
+    def test_file_descriptors(self):
+        self.assertEqual((3, 4),
+                         sut.parse_job_server_auth('-j --jobserver-auth=3,4'))
+        self.assertEqual((5, 6),
+                         sut.parse_job_server_auth(' --jobserver-fds=5,6 -j'))
+
+    def test_named_pipe(self):
+        self.assertEqual('/tmp/GMfifo1',
+                         sut.parse_job_server_auth(
+                             '-j4 --jobserver-auth=fifo:/tmp/GMfifo1'))
+
+    def test_last_one_wins(self):
+        self.assertEqual((7, 8),
+                         sut.parse_job_server_auth(
+                             '--jobserver-auth=3,4 --jobserver-auth=7,8'))
+
+
+class JobServerTest(unittest.TestCase):
+
+    def test_closed_pipe_ignored(self):
+        read_fd, write_fd = os.pipe()
+        os.close(read_fd)
+        os.close(write_fd)
+        environment = {
+            'MAKEFLAGS': '-j --jobserver-auth={0},{1}'.format(read_fd,
+                                                               write_fd)
+        }
+        self.assertIsNone(sut.get_job_server(environment))
+
+    def test_slots(self):
+        read_fd, write_fd = os.pipe()
+        try:
+            os.write(write_fd, b'+')
+            job_server = sut.JobServer(read_fd, write_fd)
+            jobs = sut.limit_jobs(job_server, ['a', 'b'])
+            # The first job runs in the implicit slot.
+            self.assertEqual('a', next(jobs))
+            # The second one takes the only token.
+            self.assertEqual('b', next(jobs))
+            job_server.release()
+            self.assertEqual(b'+', os.read(read_fd, 1))
+            job_server.release()
+            self.assertTrue(job_server.implicit_slot_free)
+        finally:
+            os.close(read_fd)
+            os.close(write_fd)
+
+    def test_close_gives_back_tokens(self):
+        read_fd, write_fd = os.pipe()
+        try:
+            os.write(write_fd, b'+')
+            job_server = sut.JobServer(read_fd, write_fd)
+            jobs = sut.limit_jobs(job_server, ['a', 'b', 'c'])
+            self.assertEqual('a', next(jobs))
+            self.assertEqual('b', next(jobs))
+            job_server.close()
+            self.assertEqual(b'+', os.read(read_fd, 1))
+            # No slot is left, but a closed job server does not wait.
+            self.assertEqual('c', next(jobs))
+        finally:
+            os.close(read_fd)
+            os.close(write_fd)
+
+    @unittest.skipUnless(os.path.isdir('/proc/self/fd'), 'needs /proc')
+    def test_read_end_non_blocking(self):
+        read_fd, write_fd = os.pipe()
+        try:
+            environment = {
+                'MAKEFLAGS': '-j --jobserver-auth={0},{1}'.format(read_fd,
+                                                                   write_fd)
+            }
+            job_server = sut.get_job_server(environment)
+            self.assertNotEqual(read_fd, job_server.read_fd)
+            try:
+                self.assertRaises(OSError, os.read, job_server.read_fd, 1)
+                # The descriptor shared with make stays blocking.
+                self.assertFalse(
+                    fcntl.fcntl(read_fd, fcntl.F_GETFL) & os.O_NONBLOCK)
+            finally:
+                os.close(job_server.read_fd)
+        finally:
+            os.close(read_fd)
+            os.close(write_fd)
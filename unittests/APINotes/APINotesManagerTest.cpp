@@ -0,0 +1,125 @@
+//===- unittests/APINotes/APINotesManagerTest.cpp - API notes manager tests ==//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/APINotes/APINotesManager.h"
+#include "clang/APINotes/APINotesReader.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace api_notes;
+
+namespace {
+
+static LangOptions getAPINotesLangOpts() {
+  LangOptions LangOpts;
+  LangOpts.APINotes = true;
+  return LangOpts;
+}
+
+/// The state of one compiler instance that looks up the API notes of a
+/// header in \p Dir.
+class APINotesInstance {
+  IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> FS;
+  FileManager FileMgr;
+  DiagnosticsEngine Diags;
+  SourceManager SourceMgr;
+  LangOptions LangOpts;
+  APINotesManager Manager;
+  std::string Header;
+
+public:
+  APINotesInstance(StringRef Dir, StringRef APINotes, time_t ModificationTime)
+      : FS(new llvm::vfs::InMemoryFileSystem),
+        FileMgr(FileSystemOptions(), FS),
+        Diags(new DiagnosticIDs, new DiagnosticOptions,
+              new IgnoringDiagConsumer),
+        SourceMgr(Diags, FileMgr), LangOpts(getAPINotesLangOpts()),
+        Manager(SourceMgr, LangOpts), Header((Dir + "/Header.h").str()) {
+    FS->addFile(Dir + "/APINotes.apinotes", ModificationTime,
+                llvm::MemoryBuffer::getMemBufferCopy(APINotes));
+    FS->addFile(Header, 0, llvm::MemoryBuffer::getMemBuffer(""));
+  }
+
+  /// Returns the reader of the API notes for the header, or null.
+  APINotesReader *getReader() {
+    auto File = FileMgr.getFile(Header);
+    if (!File)
+      return nullptr;
+    FileID FID =
+        SourceMgr.createFileID(*File, SourceLocation(), SrcMgr::C_User);
+    auto Readers = Manager.findAPINotes(SourceMgr.getLocForStartOfFile(FID));
+    return Readers.empty() ? nullptr : Readers.front();
+  }
+
+  bool hasErrorOccurred() const { return Diags.hasErrorOccurred(); }
+};
+
+// The compiled forms are shared by the whole process, so every test uses API
+// notes of its own.
+
+TEST(APINotesManagerTest, SharesCompiledAPINotes) {
+  StringRef APINotes = "Name: SharedNotes\n"
+                       "Functions:\n"
+                       "  - Name: f\n";
+  APINotesInstance First("/first", APINotes, 1);
+  APINotesInstance Second("/second", APINotes, 1);
+
+  APINotesReader *FirstReader = First.getReader();
+  APINotesReader *SecondReader = Second.getReader();
+  ASSERT_TRUE(FirstReader);
+  ASSERT_TRUE(SecondReader);
+  EXPECT_NE(FirstReader, SecondReader);
+  EXPECT_EQ(&FirstReader->getBuffer(), &SecondReader->getBuffer());
+  EXPECT_EQ("SharedNotes", SecondReader->getModuleName());
+}
+
+TEST(APINotesManagerTest, RecompilesChangedAPINotes) {
+  StringRef APINotes = "Name: ChangedNotes\n"
+                       "Functions:\n"
+                       "  - Name: f\n";
+  APINotesInstance Original("/dir", APINotes, 1);
+  APINotesInstance Touched("/dir", APINotes, 2);
+  APINotesInstance Edited("/dir",
+                          "Name: ChangedNotesEdited\n"
+                          "Functions:\n"
+                          "  - Name: f\n",
+                          1);
+
+  APINotesReader *OriginalReader = Original.getReader();
+  APINotesReader *TouchedReader = Touched.getReader();
+  APINotesReader *EditedReader = Edited.getReader();
+  ASSERT_TRUE(OriginalReader);
+  ASSERT_TRUE(TouchedReader);
+  ASSERT_TRUE(EditedReader);
+  EXPECT_NE(&OriginalReader->getBuffer(), &TouchedReader->getBuffer());
+  EXPECT_NE(&OriginalReader->getBuffer(), &EditedReader->getBuffer());
+  EXPECT_EQ("ChangedNotesEdited", EditedReader->getModuleName());
+}
+
+TEST(APINotesManagerTest, DiagnosesAPINotesAgain) {
+  StringRef APINotes = "Name: BrokenNotes\n"
+                       "Functions:\n"
+                       "  - Name: f\n"
+                       "  - Name: f\n";
+  APINotesInstance First("/first", APINotes, 1);
+  APINotesInstance Second("/second", APINotes, 1);
+
+  EXPECT_FALSE(First.getReader());
+  EXPECT_TRUE(First.hasErrorOccurred());
+  EXPECT_FALSE(Second.getReader());
+  EXPECT_TRUE(Second.hasErrorOccurred());
+}
+
+} // anonymous namespace
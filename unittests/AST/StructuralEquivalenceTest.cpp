@@ -944,5 +944,50 @@ TEST_F(StructuralEquivalenceTemplateTest, ExplicitBoolDifference) {
   EXPECT_FALSE(testStructuralMatch(First, Second));
 }
 
+struct StructuralEquivalenceCacheTest : StructuralEquivalenceTest {
+  llvm::DenseSet<std::pair<Decl *, Decl *>> EquivalentDecls;
+
+  bool isEquivalent(Decl *D0, Decl *D1) {
+    llvm::DenseSet<std::pair<Decl *, Decl *>> NonEquivalentDecls;
+    StructuralEquivalenceContext Ctx(
+        D0->getASTContext(), D1->getASTContext(), NonEquivalentDecls,
+        StructuralEquivalenceKind::Default, false, false);
+    Ctx.EquivalentDecls = &EquivalentDecls;
+    return Ctx.IsEquivalent(D0, D1);
+  }
+};
+
+TEST_F(StructuralEquivalenceCacheTest, ProvenEquivalencesAreRecorded) {
+  auto t = makeNamedDecls("struct B { int x; }; struct foo { B b; };",
+                          "struct B { int x; }; struct foo { B b; };",
+                          Lang_CXX);
+  EXPECT_TRUE(isEquivalent(get<0>(t), get<1>(t)));
+
+  auto *B0 = FirstDeclMatcher<CXXRecordDecl>().match(
+      get<0>(t)->getTranslationUnitDecl(), cxxRecordDecl(hasName("B")));
+  auto *B1 = FirstDeclMatcher<CXXRecordDecl>().match(
+      get<1>(t)->getTranslationUnitDecl(), cxxRecordDecl(hasName("B")));
+  EXPECT_TRUE(EquivalentDecls.count(std::make_pair(get<0>(t), get<1>(t))));
+  EXPECT_TRUE(EquivalentDecls.count(std::make_pair(B0, B1)));
+}
+
+TEST_F(StructuralEquivalenceCacheTest, KnownEquivalencesAreNotCheckedAgain) {
+  auto t = makeNamedDecls("struct foo { int x; };", "struct foo { char x; };",
+                          Lang_CXX);
+  EXPECT_FALSE(isEquivalent(get<0>(t), get<1>(t)));
+  EXPECT_TRUE(EquivalentDecls.empty());
+
+  EquivalentDecls.insert(std::make_pair(get<0>(t), get<1>(t)));
+  EXPECT_TRUE(isEquivalent(get<0>(t), get<1>(t)));
+}
+
+TEST_F(StructuralEquivalenceCacheTest, IncompleteDeclsAreNotRecorded) {
+  auto t = makeNamedDecls("struct B; struct foo { B *b; };",
+                          "struct B { int x; }; struct foo { B *b; };",
+                          Lang_CXX);
+  EXPECT_TRUE(isEquivalent(get<0>(t), get<1>(t)));
+  EXPECT_TRUE(EquivalentDecls.empty());
+}
+
 } // end namespace ast_matchers
 } // end namespace clang
@@ -10,9 +10,13 @@
 #include "clang/Basic/FileSystemOptions.h"
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <atomic>
 
 using namespace llvm;
 using namespace clang;
@@ -397,4 +401,147 @@ TEST_F(FileManagerTest, getFileDontOpenRealPath) {
   EXPECT_EQ((*file)->tryGetRealPathName(), ExpectedResult);
 }
 
+TEST_F(FileManagerTest, getBufferForFileSharesContents) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("shared", "h", FD, Path));
+  llvm::FileRemover Cleanup(Path);
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "int x;\n";
+  }
+
+  FileSystemOptions Opts;
+  Opts.ShareFileBuffers = true;
+  FileManager First(Opts);
+  FileManager Second(Opts);
+  FileManager Unshared{FileSystemOptions()};
+
+  auto FirstFile = First.getFile(Path);
+  auto SecondFile = Second.getFile(Path);
+  auto UnsharedFile = Unshared.getFile(Path);
+  ASSERT_TRUE(FirstFile && SecondFile && UnsharedFile);
+
+  auto FirstBuffer = First.getBufferForFile(*FirstFile);
+  auto SecondBuffer = Second.getBufferForFile(*SecondFile);
+  auto UnsharedBuffer = Unshared.getBufferForFile(*UnsharedFile);
+  auto VolatileBuffer =
+      Second.getBufferForFile(*SecondFile, /*isVolatile=*/true);
+  ASSERT_TRUE(FirstBuffer && SecondBuffer && UnsharedBuffer && VolatileBuffer);
+
+  EXPECT_EQ("int x;\n", (*SecondBuffer)->getBuffer());
+  EXPECT_EQ((*FirstBuffer)->getBufferStart(),
+            (*SecondBuffer)->getBufferStart());
+  EXPECT_NE((*FirstBuffer)->getBufferStart(),
+            (*UnsharedBuffer)->getBufferStart());
+  EXPECT_NE((*FirstBuffer)->getBufferStart(),
+            (*VolatileBuffer)->getBufferStart());
+}
+
+TEST_F(FileManagerTest, sharedFileBuffersAreReleased) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("released", "h", FD, Path));
+  llvm::FileRemover Cleanup(Path);
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "int y;\n";
+  }
+
+  FileSystemOptions Opts;
+  Opts.ShareFileBuffers = true;
+  unsigned NumShared = FileManager::getNumSharedFileBuffers();
+  {
+    std::unique_ptr<llvm::MemoryBuffer> FirstBuffer;
+    {
+      FileManager First(Opts);
+      auto File = First.getFile(Path);
+      ASSERT_TRUE(File);
+      auto Buffer = First.getBufferForFile(*File);
+      ASSERT_TRUE(Buffer);
+      FirstBuffer = std::move(*Buffer);
+    }
+    FileManager Second(Opts);
+    auto File = Second.getFile(Path);
+    ASSERT_TRUE(File);
+    auto SecondBuffer = Second.getBufferForFile(*File);
+    ASSERT_TRUE(SecondBuffer);
+    EXPECT_EQ(FirstBuffer->getBufferStart(),
+              (*SecondBuffer)->getBufferStart());
+    EXPECT_EQ(NumShared + 1, FileManager::getNumSharedFileBuffers());
+  }
+  EXPECT_EQ(NumShared, FileManager::getNumSharedFileBuffers());
+
+  // Reading the file again shares its contents anew.
+  FileManager Third(Opts);
+  auto File = Third.getFile(Path);
+  ASSERT_TRUE(File);
+  auto ThirdBuffer = Third.getBufferForFile(*File);
+  ASSERT_TRUE(ThirdBuffer);
+  EXPECT_EQ("int y;\n", (*ThirdBuffer)->getBuffer());
+  EXPECT_EQ(NumShared + 1, FileManager::getNumSharedFileBuffers());
+}
+
+/// A file system that counts the calls to status().
+class CountingFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+  std::atomic<unsigned> NumStats{0};
+
+  CountingFileSystem(IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS)
+      : ProxyFileSystem(std::move(FS)) {}
+
+  llvm::ErrorOr<llvm::vfs::Status> status(const Twine &Path) override {
+    ++NumStats;
+    return ProxyFileSystem::status(Path);
+  }
+};
+
+TEST_F(FileManagerTest, prefetchFileStatsAvoidsStats) {
+  auto InMemoryFS = IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem>(
+      new llvm::vfs::InMemoryFileSystem);
+  std::vector<std::string> Paths;
+  for (unsigned I = 0; I != 40; ++I) {
+    Paths.push_back("/inputs/file" + std::to_string(I) + ".h");
+    InMemoryFS->addFile(Paths.back(), 0, llvm::MemoryBuffer::getMemBuffer(""));
+  }
+  InMemoryFS->addFile("/inputs/other.h", 0,
+                      llvm::MemoryBuffer::getMemBuffer(""));
+  auto FS = IntrusiveRefCntPtr<CountingFileSystem>(
+      new CountingFileSystem(InMemoryFS));
+  FileSystemOptions Opts;
+  Opts.PrefetchFileStats = true;
+  FileManager Manager(Opts, FS);
+
+  Manager.prefetchFileStats(Paths);
+  EXPECT_EQ(40u, FS->NumStats);
+
+  // Only the directory of the files is stat'ed.
+  for (const std::string &Path : Paths)
+    EXPECT_TRUE(Manager.getFile(Path, /*OpenFile=*/false));
+  EXPECT_EQ(41u, FS->NumStats);
+  ASSERT_TRUE(Manager.getFile("/inputs/other.h", /*OpenFile=*/false));
+  EXPECT_EQ(42u, FS->NumStats);
+
+  // Prefetching files that have been looked up does nothing.
+  Manager.prefetchFileStats(Paths);
+  EXPECT_EQ(42u, FS->NumStats);
+}
+
+TEST_F(FileManagerTest, prefetchFileStatsNeedsOption) {
+  auto InMemoryFS = IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem>(
+      new llvm::vfs::InMemoryFileSystem);
+  std::vector<std::string> Paths;
+  for (unsigned I = 0; I != 40; ++I) {
+    Paths.push_back("/inputs/file" + std::to_string(I) + ".h");
+    InMemoryFS->addFile(Paths.back(), 0, llvm::MemoryBuffer::getMemBuffer(""));
+  }
+  auto FS = IntrusiveRefCntPtr<CountingFileSystem>(
+      new CountingFileSystem(InMemoryFS));
+  FileManager Manager(FileSystemOptions(), FS);
+
+  // The file system is not known to allow concurrent stats.
+  Manager.prefetchFileStats(Paths);
+  EXPECT_EQ(0u, FS->NumStats);
+}
+
 } // anonymous namespace
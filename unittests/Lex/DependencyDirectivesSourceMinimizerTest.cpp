@@ -724,4 +724,110 @@ TEST(MinimizeSourceToDependencyDirectivesTest, SkippedPPRangesNested) {
   EXPECT_EQ(Ranges[3].Offset + Ranges[3].Length, (int)Out.rfind("#endif"));
 }
 
+TEST(BlankOutCommentsAndDisabledBlocksTest, Comments) {
+  SmallString<128> Out;
+  StringRef Source = "/* block\n"
+                     " * comment */\n"
+                     "int a; // line \\\n"
+                     "continued\n"
+                     "const char *s = \"// string\";\n";
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(Source, Out));
+  EXPECT_STREQ("        \n"
+               "             \n"
+               "int a;         \\\n"
+               "         \n"
+               "const char *s = \"// string\";\n",
+               Out.c_str());
+
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(Source, Out,
+                                                 /*LineComments=*/false));
+  EXPECT_STREQ("        \n"
+               "             \n"
+               "int a; // line \\\n"
+               "continued\n"
+               "const char *s = \"// string\";\n",
+               Out.c_str());
+}
+
+TEST(BlankOutCommentsAndDisabledBlocksTest, Directives) {
+  SmallString<128> Out;
+  // A comment that spans lines continues the directive it is in.
+  StringRef Source = "#define A /* x */ 1\n"
+                     "#define B /* x\n"
+                     "  */ 2\n"
+                     "#include <a//b.h> // c\n";
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(Source, Out));
+  EXPECT_STREQ("#define A         1\n"
+               "#define B /* x\n"
+               "  */ 2\n"
+               "#include <a//b.h>     \n",
+               Out.c_str());
+}
+
+TEST(BlankOutCommentsAndDisabledBlocksTest, DisabledBlocks) {
+  SmallString<128> Out;
+  StringRef Source = "#if 0\n"
+                     "a\n"
+                     "#if B\n"
+                     "b /*\n"
+                     "#endif */\n"
+                     "#endif\n"
+                     "c\n"
+                     "#else\n"
+                     "d\n"
+                     "#endif\n"
+                     "#if 0 // x\n"
+                     "e\n"
+                     "/**/ #endif\n";
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(Source, Out));
+  EXPECT_STREQ("#if 0\n"
+               " \n"
+               "     \n"
+               "    \n"
+               "         \n"
+               "      \n"
+               " \n"
+               "#else\n"
+               "d\n"
+               "#endif\n"
+               "#if 0     \n"
+               " \n"
+               "     #endif\n",
+               Out.c_str());
+}
+
+TEST(BlankOutCommentsAndDisabledBlocksTest, Unsure) {
+  SmallString<128> Out;
+  ASSERT_TRUE(blankOutCommentsAndDisabledBlocks("/* x\n */ #if 0\n", Out));
+  ASSERT_TRUE(blankOutCommentsAndDisabledBlocks("a /* unterminated", Out));
+  ASSERT_TRUE(blankOutCommentsAndDisabledBlocks("// x ?\?/\n", Out));
+  ASSERT_TRUE(blankOutCommentsAndDisabledBlocks("#if 0\n"
+                                                "R\"(\n"
+                                                "#endif\n"
+                                                "int a; // x\n",
+                                                Out));
+}
+
+TEST(BlankOutCommentsAndDisabledBlocksTest, RawStrings) {
+  SmallString<128> Out;
+  StringRef Source = "const char *s = R\"(/* x */)\"; /* y */\n";
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(Source, Out));
+  EXPECT_STREQ("const char *s = R\"(/* x */)\";        \n", Out.c_str());
+
+  // Before C++11, R is an identifier and "(" a string.
+  ASSERT_FALSE(blankOutCommentsAndDisabledBlocks(
+      "#define R\n"
+      "#if 0\n"
+      "R\"(\"\n"
+      "#endif\n"
+      "int a; // x\n",
+      Out, /*LineComments=*/true, /*RawStringLiterals=*/false));
+  EXPECT_STREQ("#define R\n"
+               "#if 0\n"
+               "    \n"
+               "#endif\n"
+               "int a;     \n",
+               Out.c_str());
+}
+
 } // end anonymous namespace
@@ -0,0 +1,138 @@
+//===- unittests/Lex/PreprocessingRecordTest.cpp - Preprocessing record tests =//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/PreprocessingRecord.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TargetOptions.h"
+#include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/ModuleLoader.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+
+namespace {
+
+// The test fixture.
+class PreprocessingRecordTest : public ::testing::Test {
+protected:
+  PreprocessingRecordTest()
+    : FileMgr(FileMgrOpts),
+      DiagID(new DiagnosticIDs()),
+      Diags(DiagID, new DiagnosticOptions, new IgnoringDiagConsumer()),
+      SourceMgr(Diags, FileMgr),
+      TargetOpts(new TargetOptions)
+  {
+    TargetOpts->Triple = "x86_64-apple-darwin11.1.0";
+    Target = TargetInfo::CreateTargetInfo(Diags, TargetOpts);
+  }
+
+  /// Makes \p Source the main file, and returns the location of its start.
+  SourceLocation setMainFile(StringRef Source) {
+    FileID FID = SourceMgr.createFileID(
+        llvm::MemoryBuffer::getMemBufferCopy(Source));
+    SourceMgr.setMainFileID(FID);
+    return SourceMgr.getLocForStartOfFile(FID);
+  }
+
+  /// Returns the names of the macro expansions that \p Range encompasses.
+  static std::string getExpansionsInRange(PreprocessingRecord &PPRec,
+                                          SourceRange Range) {
+    std::string Names;
+    for (PreprocessedEntity *Entity :
+         PPRec.getPreprocessedEntitiesInRange(Range))
+      if (auto *Expansion = dyn_cast_or_null<MacroExpansion>(Entity))
+        Names += Expansion->getName()->getName();
+    return Names;
+  }
+
+  FileSystemOptions FileMgrOpts;
+  FileManager FileMgr;
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID;
+  DiagnosticsEngine Diags;
+  SourceManager SourceMgr;
+  LangOptions LangOpts;
+  std::shared_ptr<TargetOptions> TargetOpts;
+  IntrusiveRefCntPtr<TargetInfo> Target;
+};
+
+TEST_F(PreprocessingRecordTest, OutOfOrderEntities) {
+  StringRef Source = "a b c d e f g h i j k l m\n";
+  SourceLocation Start = setMainFile(Source);
+  auto Loc = [&](char Name) {
+    return Start.getLocWithOffset(Source.find(Name));
+  };
+
+  IdentifierTable Idents(LangOpts);
+  PreprocessingRecord PPRec(SourceMgr);
+  auto Add = [&](char Name) {
+    PPRec.addPreprocessedEntity(new (PPRec) MacroExpansion(
+        &Idents.get(StringRef(&Name, 1)), SourceRange(Loc(Name), Loc(Name))));
+  };
+  for (char Name : StringRef("acegikm"))
+    Add(Name);
+  // Goes before more entities than the linear search looks at.
+  Add('b');
+  // Goes before the last entity.
+  Add('l');
+
+  std::string Names;
+  for (auto I = PPRec.local_begin(), E = PPRec.local_end(); I != E; ++I) {
+    EXPECT_TRUE(PPRec.isEntityInFileID(I, SourceMgr.getMainFileID()));
+    Names += cast<MacroExpansion>(*I)->getName()->getName();
+  }
+  EXPECT_EQ("abcegiklm", Names);
+
+  EXPECT_EQ("bce", getExpansionsInRange(PPRec, SourceRange(Loc('b'),
+                                                           Loc('e'))));
+  EXPECT_EQ("kl", getExpansionsInRange(PPRec, SourceRange(Loc('j'),
+                                                          Loc('l'))));
+  EXPECT_EQ("", getExpansionsInRange(PPRec, SourceRange(Loc('d'),
+                                                        Loc('d'))));
+}
+
+TEST_F(PreprocessingRecordTest, MacroArgumentsExpandedOutOfOrder) {
+  StringRef Source = "#define M1 1\n"
+                     "#define M2 2\n"
+                     "#define FM(x, y) y + x\n"
+                     "int v = FM(M1, M2);\n";
+  SourceLocation Start = setMainFile(Source);
+
+  TrivialModuleLoader ModLoader;
+  HeaderSearch HeaderInfo(std::make_shared<HeaderSearchOptions>(), SourceMgr,
+                          Diags, LangOpts, Target.get());
+  Preprocessor PP(std::make_shared<PreprocessorOptions>(), Diags, LangOpts,
+                  SourceMgr, HeaderInfo, ModLoader,
+                  /*IILookup =*/nullptr,
+                  /*OwnsHeaderSearch =*/false);
+  PP.Initialize(*Target);
+  PP.createPreprocessingRecord();
+  PP.EnterMainSourceFile();
+
+  Token Tok;
+  do
+    PP.Lex(Tok);
+  while (Tok.isNot(tok::eof));
+
+  PreprocessingRecord &PPRec = *PP.getPreprocessingRecord();
+  SourceLocation Begin = Start.getLocWithOffset(Source.find("FM(M1"));
+  SourceLocation End = Start.getLocWithOffset(Source.rfind(')'));
+  EXPECT_EQ("FMM1M2", getExpansionsInRange(PPRec, SourceRange(Begin, End)));
+  SourceLocation M2 = Start.getLocWithOffset(Source.rfind("M2"));
+  EXPECT_EQ("M2", getExpansionsInRange(PPRec, SourceRange(M2, M2)));
+}
+
+} // anonymous namespace
@@ -0,0 +1,209 @@
+#!/usr/bin/env python
+#===- merge-header-costs.py - Rank headers by their build cost -*- python -*-===#
+#
+# Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+#
+#===------------------------------------------------------------------------===#
+
+"""Merges the header cost reports of a build and ranks the headers by the
+time the build would save if they were removed or precompiled.
+
+The reports are written by 'clang -Xclang -header-cost-report -Xclang FILE'.
+Either pass the reports of an existing build, or let this script produce them
+by parsing every file of a compilation database:
+
+  merge-header-costs.py report1.json report2.json ...
+  merge-header-costs.py -p path/to/build -j 8
+
+The estimates assume that a header costs the same in every translation unit
+it is parsed in. Removing a header saves the time spent in it, counting the
+headers it includes even if other headers include them too, so it is an upper
+bound. Precompiling it saves that time in all but one translation unit; the
+time to load the precompiled header is not subtracted.
+"""
+
+from __future__ import absolute_import, division, print_function
+
+import argparse
+import json
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+from multiprocessing.pool import ThreadPool
+
+
+def find_reports(paths):
+    for path in paths:
+        if not os.path.isdir(path):
+            yield path
+            continue
+        for root, _, files in os.walk(path):
+            for name in files:
+                if name.endswith('.json'):
+                    yield os.path.join(root, name)
+
+
+def get_arguments(entry):
+    if 'arguments' in entry:
+        return list(entry['arguments'])
+    return shlex.split(entry['command'])
+
+
+# The options that start with '-o' but do not name the output file.
+OPTIONS_STARTING_WITH_O = ('-objcmt-', '-object')
+
+# The options that make the compiler write a dependency file.
+DEPENDENCY_OPTIONS = ('-M', '-MM', '-MD', '-MMD', '-MG', '-MP', '-MV',
+                      '--write-dependencies', '--write-user-dependencies')
+
+# The options that name an output or a dependency file target, as a joined
+# or as a separate value.
+OPTIONS_WITH_VALUE = ('-o', '-MF', '-MT', '-MQ', '-MJ')
+
+
+def make_report_command(arguments, report):
+    # Only parse the file, and leave the outputs of the build, including its
+    # dependency files, alone.
+    command = []
+    skip_next = False
+    for arg in arguments:
+        if skip_next:
+            skip_next = False
+        elif arg in OPTIONS_WITH_VALUE:
+            skip_next = True
+        elif arg in DEPENDENCY_OPTIONS or arg.startswith('-Wp,-M'):
+            continue
+        elif arg.startswith(OPTIONS_WITH_VALUE[1:]):
+            continue
+        elif (not arg.startswith('-o') or
+              arg.startswith(OPTIONS_STARTING_WITH_O)):
+            command.append(arg)
+    return command + ['-fsyntax-only',
+                      '-Xclang', '-header-cost-report', '-Xclang', report]
+
+
+def produce_reports(build_dir, jobs, report_dir):
+    with open(os.path.join(build_dir, 'compile_commands.json')) as f:
+        entries = json.load(f)
+
+    def run(index_and_entry):
+        index, entry = index_and_entry
+        report = os.path.join(report_dir, '%d.json' % index)
+        command = make_report_command(get_arguments(entry), report)
+        with open(os.devnull, 'w') as devnull:
+            status = subprocess.call(command, cwd=entry['directory'],
+                                     stdout=devnull, stderr=devnull)
+        if status != 0:
+            print('warning: could not parse %s' % entry['file'],
+                  file=sys.stderr)
+            return None
+        return report
+
+    pool = ThreadPool(jobs)
+    try:
+        return [report for report in pool.map(run, enumerate(entries))
+                if report is not None]
+    finally:
+        pool.close()
+
+
+def merge_reports(reports):
+    headers = {}
+    num_units = 0
+    for path in reports:
+        with open(path) as f:
+            try:
+                report = json.load(f)
+            except ValueError:
+                print('warning: ignoring %s, which is not a report' % path,
+                      file=sys.stderr)
+                continue
+        if 'headers' not in report:
+            continue
+        num_units += 1
+        for header in report['headers']:
+            if not header['entered']:
+                continue
+            merged = headers.setdefault(os.path.realpath(header['file']), {
+                'units': 0, 'time-us': 0, 'self-time-us': 0, 'decls': 0,
+                'inclusive-decls': 0, 'max-time-us': 0})
+            merged['units'] += 1
+            merged['time-us'] += header['time-us']
+            merged['self-time-us'] += header['self-time-us']
+            merged['decls'] += header['decls']
+            merged['inclusive-decls'] += header['inclusive-decls']
+            merged['max-time-us'] = max(merged['max-time-us'],
+                                        header['time-us'])
+
+    for merged in headers.values():
+        merged['removal-savings-us'] = merged['time-us']
+        # One translation unit still pays for building the precompiled header.
+        merged['precompile-savings-us'] = (
+            merged['time-us'] - merged['time-us'] // merged['units'])
+    return num_units, headers
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('reports', nargs='*',
+                        help='Header cost reports, or directories with them')
+    parser.add_argument('-p', dest='build_dir', metavar='PATH',
+                        help='Produce the reports for the compilation '
+                             'database in PATH')
+    parser.add_argument('-j', dest='jobs', type=int, default=1,
+                        help='Number of files to parse at once (with -p)')
+    parser.add_argument('--top', type=int, default=30,
+                        help='Number of headers to list (default 30)')
+    parser.add_argument('--sort', default='removal',
+                        choices=['removal', 'precompile', 'self', 'decls'],
+                        help='What to rank the headers by (default removal)')
+    parser.add_argument('--json', action='store_true',
+                        help='Print all the merged costs as JSON')
+    args = parser.parse_args()
+
+    if not args.reports and not args.build_dir:
+        parser.error('pass either reports or a build directory')
+
+    report_dir = None
+    reports = list(find_reports(args.reports))
+    try:
+        if args.build_dir:
+            report_dir = tempfile.mkdtemp(prefix='header-costs-')
+            reports += produce_reports(args.build_dir, args.jobs, report_dir)
+        num_units, headers = merge_reports(reports)
+    finally:
+        if report_dir:
+            shutil.rmtree(report_dir)
+
+    if args.json:
+        json.dump({'units': num_units, 'headers': headers}, sys.stdout,
+                  indent=2, sort_keys=True)
+        print()
+        return 0
+
+    key = {'removal': 'removal-savings-us',
+           'precompile': 'precompile-savings-us',
+           'self': 'self-time-us',
+           'decls': 'inclusive-decls'}[args.sort]
+    ranked = sorted(headers.items(), key=lambda item: -item[1][key])
+
+    print('%d translation units, %d headers' % (num_units, len(headers)))
+    print('%10s %14s %10s %6s %10s  %s' % (
+        'removed(s)', 'precompiled(s)', 'self(s)', 'units', 'decls', 'header'))
+    for path, cost in ranked[:args.top]:
+        print('%10.3f %14.3f %10.3f %6d %10d  %s' % (
+            cost['removal-savings-us'] / 1e6,
+            cost['precompile-savings-us'] / 1e6,
+            cost['self-time-us'] / 1e6, cost['units'],
+            cost['inclusive-decls'], path))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
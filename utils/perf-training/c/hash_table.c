@@ -0,0 +1,77 @@
+// RUN: %clang -c %s
+// RUN: %clang -O2 -c %s
+// RUN: %clang_skip_driver -Wall -pedantic -c %s
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct entry {
+  char *key;
+  int value;
+  struct entry *next;
+};
+
+struct table {
+  struct entry **buckets;
+  size_t size;
+};
+
+static unsigned long hash(const char *s) {
+  unsigned long h = 5381;
+  while (*s)
+    h = h * 33 + (unsigned char)*s++;
+  return h;
+}
+
+static struct table *table_create(size_t size) {
+  struct table *t = malloc(sizeof(*t));
+  t->buckets = calloc(size, sizeof(*t->buckets));
+  t->size = size;
+  return t;
+}
+
+static struct entry *table_find(struct table *t, const char *key) {
+  struct entry *e = t->buckets[hash(key) % t->size];
+  for (; e; e = e->next)
+    if (strcmp(e->key, key) == 0)
+      return e;
+  return NULL;
+}
+
+static void table_set(struct table *t, const char *key, int value) {
+  struct entry *e = table_find(t, key);
+  if (!e) {
+    size_t b = hash(key) % t->size;
+    e = malloc(sizeof(*e));
+    e->key = strdup(key);
+    e->next = t->buckets[b];
+    t->buckets[b] = e;
+  }
+  e->value = value;
+}
+
+static void table_destroy(struct table *t) {
+  for (size_t i = 0; i < t->size; ++i) {
+    struct entry *e = t->buckets[i];
+    while (e) {
+      struct entry *next = e->next;
+      free(e->key);
+      free(e);
+      e = next;
+    }
+  }
+  free(t->buckets);
+  free(t);
+}
+
+int main(int argc, char **argv) {
+  struct table *t = table_create(64);
+  for (int i = 1; i < argc; ++i) {
+    struct entry *e = table_find(t, argv[i]);
+    table_set(t, argv[i], e ? e->value + 1 : 1);
+  }
+  for (int i = 1; i < argc; ++i)
+    printf("%s: %d\n", argv[i], table_find(t, argv[i])->value);
+  table_destroy(t);
+  return 0;
+}
@@ -0,0 +1,21 @@
+// Preprocessing throughput: the expansions below print a few hundred
+// thousand tokens, most of them punctuators, so the -E runs mostly measure
+// how fast the preprocessed output is printed.
+// RUN: %clang -E %s -o %t.i
+// RUN: %clang_skip_driver -E %s -o %t.i
+
+#define EXPR(x) (((x) << 1 | (x) & 3) ^ ~(x) % 7 >= -(x) && !(x) || (x) != 1)
+#define STMT(x) if (EXPR(x)) { a[(x) % 64] += b[(x) % 64] * c[(x) % 64]; }
+#define X4(m, x) m(x) m(x + 1) m(x + 2) m(x + 3)
+#define X16(m, x) X4(m, x) X4(m, x + 4) X4(m, x + 8) X4(m, x + 12)
+#define X64(m, x) X16(m, x) X16(m, x + 16) X16(m, x + 32) X16(m, x + 48)
+#define FN(n) void f##n(void) { X64(STMT, n * 64) }
+#define FN4(n) FN(n##0) FN(n##1) FN(n##2) FN(n##3)
+#define FN16(n) FN4(n##0) FN4(n##1) FN4(n##2) FN4(n##3)
+
+static int a[64], b[64], c[64];
+
+FN16(1)
+FN16(2)
+FN16(3)
+FN16(4)
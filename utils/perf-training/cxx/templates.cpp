@@ -0,0 +1,80 @@
+// RUN: %clang_cpp -c %s
+// RUN: %clang_cpp -O2 -c %s
+// RUN: %clang_cpp_skip_driver -Wall -pedantic -c %s
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename T> class Graph {
+  std::map<T, std::vector<T>> Edges;
+
+public:
+  void addEdge(const T &From, const T &To) { Edges[From].push_back(To); }
+
+  std::vector<T> postOrder(const T &Root) const {
+    std::vector<T> Order;
+    std::map<T, bool> Visited;
+    std::function<void(const T &)> Visit = [&](const T &Node) {
+      if (Visited[Node])
+        return;
+      Visited[Node] = true;
+      auto It = Edges.find(Node);
+      if (It != Edges.end())
+        for (const T &Succ : It->second)
+          Visit(Succ);
+      Order.push_back(Node);
+    };
+    Visit(Root);
+    return Order;
+  }
+};
+
+struct Shape {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Square : Shape {
+  double Side;
+  explicit Square(double Side) : Side(Side) {}
+  double area() const override { return Side * Side; }
+};
+
+struct Circle : Shape {
+  double Radius;
+  explicit Circle(double Radius) : Radius(Radius) {}
+  double area() const override { return 3.14159 * Radius * Radius; }
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Graph<std::string> G;
+  for (int I = 1; I + 1 < argc; I += 2)
+    G.addEdge(argv[I], argv[I + 1]);
+  std::vector<std::string> Order = G.postOrder(argc > 1 ? argv[1] : "");
+
+  Graph<int> Numbers;
+  for (int I = 0; I < 100; ++I)
+    Numbers.addEdge(I, (I * 7) % 100);
+
+  std::vector<std::unique_ptr<Shape>> Shapes;
+  for (int I = 0; I < argc; ++I) {
+    if (I % 2)
+      Shapes.push_back(std::make_unique<Square>(I));
+    else
+      Shapes.push_back(std::make_unique<Circle>(I));
+  }
+  std::sort(Shapes.begin(), Shapes.end(),
+            [](const std::unique_ptr<Shape> &A,
+               const std::unique_ptr<Shape> &B) {
+              return A->area() < B->area();
+            });
+  return static_cast<int>(Order.size() + Numbers.postOrder(0).size() +
+                          Shapes.size());
+}
@@ -0,0 +1,26 @@
+#ifndef BENCH_CONTAINERS_H
+#define BENCH_CONTAINERS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+template <typename T> struct Histogram {
+  std::map<T, unsigned> Counts;
+
+  void add(const T &Value) { ++Counts[Value]; }
+
+  std::vector<T> mostFrequent(unsigned N) const {
+    std::vector<std::pair<unsigned, T>> Sorted;
+    for (const auto &Entry : Counts)
+      Sorted.push_back({Entry.second, Entry.first});
+    std::vector<T> Result;
+    for (auto It = Sorted.rbegin(); It != Sorted.rend() && N; ++It, --N)
+      Result.push_back(It->second);
+    return Result;
+  }
+};
+
+using WordHistogram = Histogram<std::string>;
+
+#endif
@@ -0,0 +1,12 @@
+// The first compilation builds the module, the second one only loads it.
+// RUN: rm -rf %t.cache
+// RUN: %clang_cpp -fmodules -fmodules-cache-path=%t.cache -I %S/Inputs -c %s
+// RUN: %clang_cpp -fmodules -fmodules-cache-path=%t.cache -I %S/Inputs -DREUSE_MODULE_CACHE -c %s
+#include "bench_containers.h"
+
+int main(int argc, char **argv) {
+  WordHistogram Words;
+  for (int I = 1; I < argc; ++I)
+    Words.add(argv[I]);
+  return static_cast<int>(Words.mostFrequent(3).size());
+}
@@ -0,0 +1,67 @@
+// RUN: %clang -c %s
+// RUN: %clang_skip_driver -Wall -c %s
+
+__attribute__((objc_root_class))
+@interface Object {
+  int refCount;
+}
+- (instancetype)retain;
+- (void)release;
+@end
+
+@protocol Drawable
+- (double)area;
+@optional
+- (const char *)name;
+@end
+
+@interface Rectangle : Object <Drawable> {
+  double width;
+  double height;
+}
+- (void)setWidth:(double)w height:(double)h;
+@end
+
+@interface Square : Rectangle
+- (instancetype)initWithSide:(double)side;
+@end
+
+@implementation Object
+- (instancetype)retain {
+  ++refCount;
+  return self;
+}
+- (void)release {
+  --refCount;
+}
+@end
+
+@implementation Rectangle
+- (void)setWidth:(double)w height:(double)h {
+  width = w;
+  height = h;
+}
+- (double)area {
+  return width * height;
+}
+- (const char *)name {
+  return "rectangle";
+}
+@end
+
+@implementation Square
+- (instancetype)initWithSide:(double)side {
+  [self setWidth:side height:side];
+  return self;
+}
+- (const char *)name {
+  return "square";
+}
+@end
+
+double totalArea(id<Drawable> *shapes, int count) {
+  double total = 0;
+  for (int i = 0; i < count; ++i)
+    total += [shapes[i] area];
+  return total;
+}
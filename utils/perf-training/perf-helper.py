@@ -16,6 +16,8 @@ import time
 import bisect
 import shlex
 import tempfile
+import json
+import re
 
 test_env = { 'PATH'    : os.environ['PATH'] }
 
@@ -160,6 +162,208 @@ def cc1(args):
   subprocess.check_call(cc1_cmd)
   return 0
 
+def parse_time_report(output):
+  # Collect the wall times of the timers in the -ftime-report output, keyed by
+  # '<timer group>: <timer>'.
+  phases = {}
+  lines = output.split('\n')
+  group = None
+  wall_column = None
+  has_mem_column = False
+  for i, ln in enumerate(lines):
+    # A timer group starts with its title between two lines of '='.
+    if (ln.startswith('===-') and i + 2 < len(lines) and
+        lines[i + 2].startswith('===-')):
+      group = lines[i + 1].strip()
+      wall_column = None
+      continue
+    if group is None:
+      continue
+
+    if '--- Name ---' in ln:
+      columns = re.findall(r'-{2,}\s*([^-]+?)\s*-{2,}', ln)
+      wall_column = (columns.index('Wall Time') if 'Wall Time' in columns
+                     else None)
+      has_mem_column = 'Mem' in columns
+      continue
+    if wall_column is None:
+      continue
+
+    times = list(re.finditer(r'(\d+\.\d+) \(\s*[\d.]+%\)', ln))
+    if len(times) <= wall_column:
+      continue
+    name = ln[times[-1].end():].strip()
+    if has_mem_column:
+      name = name.split(None, 1)[-1]
+    phases['%s: %s' % (group, name)] = float(times[wall_column].group(1))
+  return phases
+
+def parse_perf_stat_output(path):
+  # perf stat -x writes '<count>,<unit>,<event>,...' for every event.
+  with open(path) as f:
+    for ln in f:
+      fields = ln.strip().split(',')
+      if len(fields) > 2 and fields[2].startswith('instructions'):
+        return int(fields[0]) if fields[0].isdigit() else None
+  return None
+
+def get_benchmark_key(cmd, opts):
+  # Name the compilation by its command line, with the source and the build
+  # directories left out so that the key is the same in every checkout.
+  key = ' '.join([os.path.basename(cmd[0])] + cmd[1:])
+  if opts.source_root:
+    key = key.replace(opts.source_root, '<src>')
+  if opts.exec_root:
+    key = key.replace(opts.exec_root, '<build>')
+  if opts.cc1:
+    key += ' (cc1)'
+  return key
+
+def bench(args):
+  parser = argparse.ArgumentParser(prog='perf-helper bench',
+    description='compiler wrapper for compile time benchmarks')
+  parser.add_argument('--cc1', required=False, action='store_true',
+    help='Execute cc1 directly (don\'t measure the driver)')
+  parser.add_argument('--instructions', required=False, action='store_true',
+    help='Count the instructions executed with perf stat')
+  parser.add_argument('--source-root', metavar='path', required=False,
+    default=None, help='Source directory to leave out of the benchmark name')
+  parser.add_argument('--exec-root', metavar='path', required=False,
+    default=None, help='Build directory to leave out of the benchmark name')
+  parser.add_argument('cmd', nargs='*', help='')
+
+  # Use python's arg parser to handle all leading option arguments, but pass
+  # everything else through to the compiler
+  first_cmd = next(arg for arg in args if not arg.startswith("--"))
+  last_arg_idx = args.index(first_cmd)
+
+  opts = parser.parse_args(args[:last_arg_idx])
+  cmd = args[last_arg_idx:]
+  key = get_benchmark_key(cmd, opts)
+
+  if opts.cc1:
+    cc1_env = dict(test_env)
+    cc1_env["LLVM_PROFILE_FILE"] = os.devnull
+    cmd = get_cc1_command_for_args(cmd, cc1_env)
+  cmd = cmd + ['-ftime-report']
+
+  perf_output = None
+  if opts.instructions:
+    fd, perf_output = tempfile.mkstemp(suffix='.perf')
+    os.close(fd)
+    cmd = ['perf', 'stat', '-x', ',', '-e', 'instructions',
+           '-o', perf_output, '--'] + cmd
+
+  start_time = time.time()
+  p = subprocess.Popen(cmd, stderr=subprocess.PIPE, universal_newlines=True)
+  output = p.stderr.read()
+  peak_rss_kb = None
+  if hasattr(os, 'wait4'):
+    # The resource usage of the child covers the processes it waited for,
+    # which is how the driver runs cc1.
+    _, status, usage = os.wait4(p.pid, 0)
+    p.returncode = (os.WEXITSTATUS(status) if os.WIFEXITED(status)
+                    else -os.WTERMSIG(status))
+    peak_rss_kb = usage.ru_maxrss
+    if sys.platform == 'darwin':
+      peak_rss_kb //= 1024
+  else:
+    p.wait()
+  elapsed = time.time() - start_time
+
+  sys.stderr.write(output)
+  instructions = None
+  if perf_output:
+    instructions = parse_perf_stat_output(perf_output)
+    os.remove(perf_output)
+  if p.returncode != 0:
+    return p.returncode
+
+  with open("%d.bench" % os.getpid(), "w") as f:
+    json.dump({'key': key,
+               'wall': elapsed,
+               'peak_rss_kb': peak_rss_kb,
+               'instructions': instructions,
+               'phases': parse_time_report(output)}, f, indent=2)
+  return 0
+
+def load_benchmark_results(path):
+  # Collect the results of a benchmark run by compilation. A compilation that
+  # ran more than once gets the best value of every metric, which is the one
+  # least disturbed by other work on the machine.
+  results = {}
+  for filename in findFilesWithExtension(path, "bench"):
+    with open(filename) as f:
+      record = json.load(f)
+    metrics = {'wall time': record['wall'],
+               'peak RSS (KB)': record['peak_rss_kb'],
+               'instructions': record['instructions']}
+    for phase, seconds in record['phases'].items():
+      metrics['time: ' + phase] = seconds
+    best = results.setdefault(record['key'], {})
+    for metric, value in metrics.items():
+      if value is None:
+        continue
+      best[metric] = min(best.get(metric, value), value)
+  return results
+
+def compare_bench(args):
+  parser = argparse.ArgumentParser(prog='perf-helper compare-bench',
+    description='Compares compile time benchmark results with a baseline')
+  parser.add_argument('path', help='Directory with the results of a run')
+  parser.add_argument('--baseline', metavar='path', required=True,
+    help='Results to compare with')
+  parser.add_argument('--update', required=False, action='store_true',
+    help='Store the results as the new baseline instead of comparing them')
+  parser.add_argument('--threshold', metavar='percent', type=float,
+    default=5.0, help='Report metrics that grew by more than this percentage '
+    '(default 5)')
+  parser.add_argument('--min-time', metavar='seconds', type=float,
+    default=0.01, help='Ignore timers that took less than this in the '
+    'baseline, as they are mostly noise (default 0.01)')
+  opts = parser.parse_args(args)
+
+  results = load_benchmark_results(opts.path)
+  if not results:
+    print('error: no benchmark results in %s' % opts.path, file=sys.stderr)
+    return 1
+
+  if opts.update:
+    with open(opts.baseline, 'w') as f:
+      json.dump(results, f, indent=2, sort_keys=True)
+    print('stored the results of %d compilations in %s' % (
+      len(results), opts.baseline))
+    return 0
+
+  if not os.path.exists(opts.baseline):
+    print('error: no baseline at %s, store one with --update' %
+      opts.baseline, file=sys.stderr)
+    return 1
+  with open(opts.baseline) as f:
+    baseline = json.load(f)
+
+  num_regressions = 0
+  for key in sorted(results):
+    if key not in baseline:
+      print('note: no baseline for %s' % key)
+      continue
+    for metric in sorted(results[key]):
+      old = baseline[key].get(metric)
+      new = results[key][metric]
+      if not old:
+        continue
+      if metric.startswith('time: ') and old < opts.min_time:
+        continue
+      change = 100. * (new - old) / old
+      if change > opts.threshold:
+        print('regression: %s: %s: %s -> %s (%+.1f%%)' % (
+          key, metric, old, new, change))
+        num_regressions += 1
+
+  print('compared %d compilations, %d regressions' % (
+    len(results), num_regressions))
+  return 1 if num_regressions else 0
+
 def parse_dtrace_symbol_file(path, all_symbols, all_symbols_set,
                              missing_symbols, opts):
   def fix_mangling(symbol):
@@ -397,6 +601,8 @@ commands = {'clean' : clean,
   'merge' : merge, 
   'dtrace' : dtrace,
   'cc1' : cc1,
+  'bench' : bench,
+  'compare-bench' : compare_bench,
   'gen-order-file' : genOrderFile}
 
 def main():